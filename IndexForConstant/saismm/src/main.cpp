@@ -5,12 +5,47 @@
 
 using namespace wtl;
 int main(int argc, char ** argv) {
+	if (argc < 2) {
+		std::cerr << "usage: main input_path [--d num] [--d-high num] [--auto-d] [--lean] [--mmap]\n";
+		std::cerr << "--d num: threshold for short lms-substrings at the top level (3 to 255, default: " << (uint32)D_LOW << ").\n";
+		std::cerr << "--d-high num: threshold for short lms-substrings at the deeper levels (3 to 255, default: " << (uint32)D_HIGH << ").\n";
+		std::cerr << "--auto-d: choose the threshold at the top level by sampling the input.\n";
+		std::cerr << "--lean: keep short lms-substrings in sa instead of a separate array, slower but uses less memory.\n";
+		std::cerr << "--mmap: map the input read-only and build sa in the mapped output file.\n";
+		return -1;
+	}
+
 	std::string corpora_input(argv[1]);
 	std::string corpora_output(std::string(argv[1]).append(".sa"));
 
-	SAISComputation<uint8>(corpora_input, 255, corpora_output);
+	uint8 dLow = D_LOW, dHigh = D_HIGH;
+	bool lean = false, mmap = false;
+	for (int i = 2; i < argc; ++i) {
+		std::string param(argv[i]);
+		if ((param == "--d" || param == "--d-high") && i + 1 < argc) {
+			int d = std::stoi(argv[++i]);
+			if (d < 3 || d > 255) {
+				std::cerr << "d must be in [3, 255].\n";
+				return -1;
+			}
+			(param == "--d" ? dLow : dHigh) = d;
+		}
+		else if (param == "--auto-d") {
+			dLow = 0; //choose by sampling
+		}
+		else if (param == "--lean") {
+			lean = true;
+		}
+		else if (param == "--mmap") {
+			mmap = true;
+		}
+		else {
+			std::cerr << "unknown param: " << param << "\n";
+			return -1;
+		}
+	}
+
+	SAISComputation<uint8>(corpora_input, 255, corpora_output, dLow, dHigh, lean, mmap);
 
 	return 0;
 }
-
-
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file mmapio.h
+/// \brief Memory-mapped input and output files for saismm.
+///
+/// The input string is mapped read-only with a virtual sentinel, the SA is written through a shared writable mapping.
+///////////////////////////////////////////////////////////
+
+#ifndef MMAPIO_H
+#define MMAPIO_H
+
+#include "mycommon.h"
+#include "namespace.h"
+#include <cstdlib>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+WTL_BEG_NAMESPACE
+
+//huge pages cut TLB misses in the induce loops, the hint is ignored if unsupported (e.g., file-backed mappings on most file systems).
+inline void adviseHugePage(void * _addr, size_t _len) {
+#ifdef MADV_HUGEPAGE
+	madvise(_addr, _len, MADV_HUGEPAGE);
+#endif
+}
+
+//map a file of _n characters read-only, followed by a virtual sentinel (zero).
+//an anonymous zero-filled region one character longer is reserved and the file is mapped over its head,
+//so the sentinel is either in the zero-filled tail of the last file page or in the anonymous region.
+template<typename charT>
+charT * mapInput(const std::string & _name, uint32 & _n, size_t & _len) {
+	int fd = open(_name.c_str(), O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		std::cerr << "cannot open " << _name << std::endl;
+		exit(-1);
+	}
+	_n = st.st_size / sizeof(charT);
+	size_t fileLen = (size_t)_n * sizeof(charT);
+	_len = fileLen + sizeof(charT);
+
+	char *base = (char*)mmap(nullptr, _len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED || (fileLen > 0 && mmap(base, fileLen, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+		std::cerr << "cannot map " << _name << std::endl;
+		exit(-1);
+	}
+	close(fd);
+	adviseHugePage(base, _len);
+	return (charT*)base;
+}
+
+//create a file of _num elements and map it for writing, dirty pages are flushed by the kernel.
+template<typename T>
+T * mapOutput(const std::string & _name, size_t _num, size_t & _len) {
+	int fd = open(_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	_len = _num * sizeof(T);
+	if (fd < 0 || ftruncate(fd, _len) != 0) {
+		std::cerr << "cannot create " << _name << std::endl;
+		exit(-1);
+	}
+	void *base = mmap(nullptr, _len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		std::cerr << "cannot map " << _name << std::endl;
+		exit(-1);
+	}
+	close(fd);
+	adviseHugePage(base, _len);
+	return (T*)base;
+}
+
+//unmap an output file and cut it to _size bytes.
+inline void unmapOutput(void * _addr, size_t _len, const std::string & _name, size_t _size) {
+	munmap(_addr, _len);
+	if (truncate(_name.c_str(), _size) != 0) {
+		std::cerr << "cannot truncate " << _name << std::endl;
+		exit(-1);
+	}
+}
+
+WTL_END_NAMESPACE
+#endif
@@ -23,5 +23,15 @@ constexpr uint8 B_TYPE = 2;
 constexpr uint8 D_LOW = 5; 
 constexpr uint8 D_HIGH = 4;
 
+//auto-tuning of D_LOW: the smallest D in [D_AUTO_MIN, D_AUTO_MAX] making at least D_AUTO_COVERAGE of the sampled lms-substrings short.
+//induction is cheaper than std::sort in RAM, so a low coverage is preferred (D = 3 measured fastest on dna, zipf and tokens corpora).
+constexpr uint8 D_AUTO_MIN = 3;
+constexpr uint8 D_AUTO_MAX = 16;
+constexpr double D_AUTO_COVERAGE = 0.3;
+constexpr uint32 D_SAMPLE_NUM = 64; //number of sampled chunks
+constexpr uint32 D_SAMPLE_LEN = 1024 * 1024; //number of characters in a sampled chunk
+
+constexpr uint32 RADIX_SORT_MIN = 64; //ranges of packed substrings smaller than this are sorted by std::sort
+
 WTL_END_NAMESPACE
 #endif
@@ -4,8 +4,10 @@
 #include "mycommon.h"
 #include "namespace.h"
 #include "sachecker.h"
+#include "mmapio.h"
 #include <algorithm>
 #include <fstream>
+#include <limits>
 #include <vector>
 
 WTL_BEG_NAMESPACE
@@ -17,27 +19,44 @@ WTL_BEG_NAMESPACE
 template<typename charT>
 class SAIS;
 
+template<typename charT>
+uint8 chooseD(const charT * _s, const uint32 _n);
+
 template<typename charT>
 class SAISComputation {
 public:
-	SAISComputation(std::string & _sName, uint32 _K, std::string & _saName);
+	SAISComputation(std::string & _sName, uint32 _K, std::string & _saName, uint8 _DLow = D_LOW, uint8 _DHigh = D_HIGH, bool _lean = false, bool _mmap = false); //_DLow = 0: choose D_LOW by sampling.
 };
 
 template<typename charT>
-SAISComputation<charT>::SAISComputation(std::string & _sName, uint32 _K, std::string & _saName) {
-	std::ifstream fin(_sName, std::ios_base::in | std::ios_base::binary);
-	fin.seekg(0, std::ios_base::end);
+SAISComputation<charT>::SAISComputation(std::string & _sName, uint32 _K, std::string & _saName, uint8 _DLow, uint8 _DHigh, bool _lean, bool _mmap) {
+	uint32 n;
+	charT *s;
+	uint32 *sa;
+	size_t sLen = 0, saLen = 0;
+
+	if (_mmap) { //map s read-only with a virtual sentinel, build sa in the mapped output file.
+		s = mapInput<charT>(_sName, n, sLen);
+		sa = mapOutput<uint32>(_saName, n + 1, saLen);
+	}
+	else {
+		std::ifstream fin(_sName, std::ios_base::in | std::ios_base::binary);
+		fin.seekg(0, std::ios_base::end);
+
+		n = fin.tellg() / sizeof(charT);
+		s = new charT[n + 1];
+		sa = new uint32[n + 1];
 
-	uint32 n = fin.tellg() / sizeof(charT);
-	charT *s = new charT[n + 1];
-	uint32 *sa = new uint32[n + 1];
+		fin.seekg(0, std::ios_base::beg);
+		fin.read((char*)s, n * sizeof(charT) / sizeof(char));
+		s[n] = 0; //append the sentinel
+	}
 
-	fin.seekg(0, std::ios_base::beg);
-	fin.read((char*)s, n * sizeof(charT) / sizeof(char));
-	s[n] = 0; //append the sentinel
 
+	if (_DLow == 0) _DLow = chooseD(s, n);
+	std::cerr << "d low: " << (uint32)_DLow << " d high: " << (uint32)_DHigh << (_lean ? " lean mode" : "") << std::endl;
 
-	SAIS<charT>(s, sa, n + 1, _K, 0, D_LOW);
+	SAIS<charT>(s, sa, n + 1, _K, 0, _DLow, _DHigh, _lean);
 
 #ifdef _verify_sa  
 	std::cerr << "\nstart checking\n";
@@ -57,6 +76,12 @@ SAISComputation<charT>::SAISComputation(std::string & _sName, uint32 _K, std::st
 
 #endif
 
+	if (_mmap) { //keep the same n elements as written below.
+		unmapOutput(sa, saLen, _saName, n * sizeof(uint32));
+		munmap(s, sLen);
+		return;
+	}
+
 	std::ofstream fout(_saName, std::ios_base::out | std::ios_base::binary);
 	fout.seekp(0, std::ios_base::beg);
 	fout.write((char*)sa, n * sizeof(uint32) / sizeof(char));
@@ -88,10 +113,11 @@ inline int lexcompare_type_3way(Iterator _beginA, Iterator _endA, Iterator _begi
 
 
 struct SubstringPtr {
+	uint64_t key; //packed characters, valid if packable (see packSubstring).
 	uint32 pos;
 	uint8 len; // D <= 256.
 
-	SubstringPtr(const uint32 _pos, const uint8 _len) : pos(_pos), len(_len) {}
+	SubstringPtr(const uint32 _pos, const uint8 _len, const uint64_t _key = 0) : key(_key), pos(_pos), len(_len) {}
 };
 
 template<typename charT>
@@ -102,6 +128,95 @@ struct SubstringPtrSort {
 	}
 };
 
+struct SubstringKeySort {
+	bool operator() (const SubstringPtr & _a, const SubstringPtr & _b) {
+		return _a.key < _b.key;
+	}
+};
+
+
+//a small-length lms-substring is packable if its characters and a tie byte fit in 64 bits.
+template<typename charT>
+inline bool isPackable(const uint8 _D) {
+	return sizeof(charT) * _D + 1 <= sizeof(uint64_t);
+}
+
+//pack the characters from the highest byte, pad them with the largest character and append D + 1 - len as the lowest byte.
+//comparing the keys is equivalent to lexcompare_type_3way, where a proper prefix is larger.
+template<typename charT>
+inline uint64_t packSubstring(const charT * _s, const uint8 _len, const uint8 _D) {
+	uint64_t key = 0;
+	for (uint8 i = 0; i < _D; ++i) {
+		key = (key << (8 * sizeof(charT))) | (i < _len ? (uint64_t)_s[i] : (uint64_t)std::numeric_limits<charT>::max());
+	}
+	return (key << 8) | (uint8)(_D + 1 - _len);
+}
+
+//sort packed substrings by an in-place msd radix sort (american flag sort), byte by byte from the _byte-th byte of the keys.
+//the keys are sorted in the cache, no character is fetched from the text.
+inline void radixSortSubstrings(SubstringPtr * _beg, SubstringPtr * _end, int _byte) {
+	if (_end - _beg < RADIX_SORT_MIN) {
+		std::sort(_beg, _end, SubstringKeySort());
+		return;
+	}
+	uint32 shift = 8 * _byte, cnt[256] = {0}, head[256], tail[256], sum = 0;
+	for (SubstringPtr * it = _beg; it != _end; ++it) ++cnt[(it->key >> shift) & 0xFF];
+	for (uint32 b = 0; b < 256; ++b) { head[b] = sum; sum += cnt[b]; tail[b] = sum; }
+	for (uint32 b = 0; b < 256; ++b) {
+		while (head[b] < tail[b]) { //cycle leader: move each element to its bucket.
+			SubstringPtr cur = _beg[head[b]];
+			uint32 d = (cur.key >> shift) & 0xFF;
+			while (d != b) {
+				std::swap(cur, _beg[head[d]++]);
+				d = (cur.key >> shift) & 0xFF;
+			}
+			_beg[head[b]++] = cur;
+		}
+	}
+	if (_byte == 0) return;
+	for (uint32 b = 0; b < 256; ++b) {
+		if (cnt[b] > 1) radixSortSubstrings(_beg + tail[b] - cnt[b], _beg + tail[b], _byte - 1);
+	}
+}
+
+
+//sample D_SAMPLE_NUM chunks evenly spaced over s[0, _n) and classify the lms-substrings completely contained in a chunk by their lengths.
+//the type of the rightmost character in a chunk is unknown, so the lms-substring ending at the first lms-char found in a chunk is dropped.
+template<typename charT>
+uint8 chooseD(const charT * _s, const uint32 _n) {
+	std::vector<uint64_t> lenCnt(D_AUTO_MAX + 2, 0); //the last one counts those longer than D_AUTO_MAX
+	uint64_t lmsNum = 0;
+	uint32 chunkNum = std::max(std::min(D_SAMPLE_NUM, _n / D_SAMPLE_LEN), (uint32)1), chunkLen = std::min(D_SAMPLE_LEN, _n);
+
+	for (uint32 k = 0; k < chunkNum; ++k) {
+		uint32 beg = (uint64_t)(_n - chunkLen) * k / chunkNum, rightLmsPos = 0;
+		uint8 lastT = L_TYPE, curT;
+		for (uint32 i = beg + chunkLen - 1; i > beg; --i) {
+			curT = (_s[i - 1] < _s[i] || (_s[i - 1] == _s[i] && lastT == S_TYPE)) ? S_TYPE : L_TYPE;
+			if (curT == L_TYPE && lastT == S_TYPE) { //_s[i] is an lms-char
+				if (rightLmsPos != 0) {
+					++lenCnt[std::min(rightLmsPos - i + 1, (uint32)D_AUTO_MAX + 1)], ++lmsNum;
+				}
+				rightLmsPos = i;
+			}
+			lastT = curT;
+		}
+	}
+
+	uint8 d = D_AUTO_MIN;
+	uint64_t shortNum = 0;
+	for (uint32 len = 0; len <= D_AUTO_MIN; ++len) shortNum += lenCnt[len];
+	for (; d < D_AUTO_MAX && shortNum < D_AUTO_COVERAGE * lmsNum; ++d) shortNum += lenCnt[d + 1];
+	if (shortNum < D_AUTO_COVERAGE * lmsNum) { //no D reaches the coverage (e.g., long runs), increasing D gains nothing
+		d = D_AUTO_MIN;
+		shortNum = 0;
+		for (uint32 len = 0; len <= D_AUTO_MIN; ++len) shortNum += lenCnt[len];
+	}
+
+	std::cerr << "auto d: " << (uint32)d << " (sampled lms-substrings: " << lmsNum << ", short: " << shortNum << ", long: " << lmsNum - shortNum << ")" << std::endl;
+	return d;
+}
+
 
 template<typename charT>
 class SAIS {
@@ -109,23 +224,28 @@ private:
 	//fuction member
 	charT *mS; //s
 	uint32 *mSA; //sa
-	uint8 *mT;  //type
+	uint8 *mT;  //type, one bit per type (see getType).
 	uint32 *mBkt; //bucket
 	uint8 D;
+	uint8 mDHigh; //D for the recursion
+	bool mPacked; //small-length lms-substrings are sorted and named by packed keys
+	bool mLean; //keep small-length lms-substrings in the free part of sa instead of a separate vector
 	
 	//data member
 	uint32 mNum;
 	uint32 mK;
 	uint32 mLevel;
 public:
-	SAIS(charT *_s, uint32 *_sa, uint32 _num, uint32 _K, uint32 _level, uint8 _D) :mS(_s), mSA(_sa), mNum(_num), mK(_K), mLevel(_level), D(_D), mT(nullptr), mBkt(nullptr) {
+	SAIS(charT *_s, uint32 *_sa, uint32 _num, uint32 _K, uint32 _level, uint8 _D, uint8 _DHigh = D_HIGH, bool _lean = false) :mS(_s), mSA(_sa), mT(nullptr), mBkt(nullptr), D(_D), mDHigh(_DHigh), mPacked(false), mLean(_lean), mNum(_num), mK(_K), mLevel(_level) {
 		run();
 	}
 	void getBuckets(bool _end);
 	void induceSAL(bool _sortStr);
 	void induceSAS(bool _sortStr);
 	bool isLMS(uint32 _pos); //determine whether mS[_pos] is an lms-char.
+	uint8 getType(uint32 _pos); //get the type of mS[_pos]
 	void computeType(uint32 _pos); //compute the type of mS[_pos]
+	uint32 collectSubstrings(uint32 *_buf); //collect the start positions of small-length lms-substrings into _buf (if not nullptr) and return the number.
 	void run();
 	int compareSubstring(uint32 substringA_spos, uint32 substringB_spos);
 };
@@ -146,7 +266,7 @@ void SAIS<charT>::induceSAL(bool _sortStr) {
 	for (i = 0; i < mNum; ++i) {
 		if (mSA[i] != UINT32_MAX && mSA[i] != 0) { //induce non-empty element
 			j = mSA[i] - 1;
-			if (j >= 0 && !mT[j]) {
+			if (j >= 0 && !getType(j)) {
 				mSA[mBkt[mS[j]]++] = j; //induced L-type
 				if (_sortStr) {
 					mSA[i] = UINT32_MAX; //clear current element if it induces an L_TYPE.
@@ -164,7 +284,7 @@ void SAIS<charT>::induceSAS(bool _sortStr) {
 	for (i = mNum - 1; i >= 0; --i) {
 		if (mSA[i] != UINT32_MAX && mSA[i] != 0) { //induce non-empty element
 			j = mSA[i] - 1;
-			if (j >= 0 && mT[j]) {
+			if (j >= 0 && getType(j)) {
 				mSA[mBkt[mS[j]]--] = j; //induced S-type
 				if (_sortStr) {
 					mSA[i] = UINT32_MAX; //clear current element if it induces an S_TYPE.
@@ -177,14 +297,36 @@ void SAIS<charT>::induceSAS(bool _sortStr) {
 
 template<typename charT>
 bool SAIS<charT>::isLMS(uint32 _pos) {
-	return (_pos > 0 && mT[_pos] && !mT[_pos - 1]);
+	return (_pos > 0 && getType(_pos) && !getType(_pos - 1));
+}
+
+//L_TYPE and S_TYPE are stored as bits, the only B_TYPE is the sentinel.
+template<typename charT>
+uint8 SAIS<charT>::getType(uint32 _pos) {
+	return (_pos == mNum - 1) ? B_TYPE : (mT[_pos >> 3] >> (_pos & 7)) & 1;
 }
 
 
 //compute T[0, n - 3]. Note that, T[n - 2] = L_TYPE, T[n - 1] = B_TYPE.
 template<typename charT>
 void SAIS<charT>::computeType(uint32 _pos) {
-	mT[_pos] = (mS[_pos] < mS[_pos + 1] || mS[_pos] == mS[_pos + 1] && mT[_pos + 1]) ? S_TYPE : L_TYPE;
+	if (mS[_pos] < mS[_pos + 1] || mS[_pos] == mS[_pos + 1] && getType(_pos + 1)) mT[_pos >> 3] |= 1 << (_pos & 7); //S_TYPE
+}
+
+//scan from right to left as the insertion of lms-substrings into sa does.
+template<typename charT>
+uint32 SAIS<charT>::collectSubstrings(uint32 *_buf) {
+	uint32 i, rightLmsPos = 0, num = 0;
+	for (i = mNum - 3; i >= 1; --i) {
+		if (isLMS(i)) {
+			if (rightLmsPos != 0 && rightLmsPos - i + 1 <= D) {
+				if (_buf != nullptr) _buf[num] = i;
+				++num;
+			}
+			rightLmsPos = i;
+		}
+	}
+	return num;
 }
 
 template<typename charT>
@@ -198,12 +340,11 @@ void SAIS<charT>::run() {
 #endif
 
 	uint32 i, j;
-	mT = new uint8[mNum]; //one byte per type.
-	std::vector<SubstringPtr> substrings; //records the start position of each lms-substring of which the length is no more than D. 
-	substrings.reserve(mNum / 2); //the number of substrings is no more than mNum / 2;
+	mT = new uint8[mNum / 8 + 1](); //one bit per type, all L_TYPE.
+	std::vector<SubstringPtr> substrings; //records the start position of each lms-substring of which the length is no more than D (empty in lean mode).
+	mPacked = !mLean && isPackable<charT>(D);
 
-	// scan s to compute t
-	mT[mNum - 1] = B_TYPE; mT[mNum - 2] = L_TYPE;
+	// scan s to compute t, T[n - 2] = L_TYPE and T[n - 1] = B_TYPE.
 	for (i = mNum - 3; i >= 0; --i) {
 		computeType(i);
 		if (i == 0) break;
@@ -214,8 +355,11 @@ void SAIS<charT>::run() {
 	getBuckets(true); // find ends of buckets
 	for(i = 0; i < mNum; ++i) mSA[i] = UINT32_MAX;
 
-	//find the rightmost lms-char except for the sentinel
+	//count the small-length lms-substrings to reserve space for them.
 	uint32 leftLmsPos, rightLmsPos, substringLen;
+	if (!mLean) substrings.reserve(collectSubstrings(nullptr));
+
+	//find the rightmost lms-char except for the sentinel
 	for (i = mNum - 3; i >= 1; --i) {//i != 0
 		if (isLMS(i)) {
 			rightLmsPos = i--;
@@ -227,8 +371,8 @@ void SAIS<charT>::run() {
 		if (isLMS(i)) {
 			leftLmsPos = i;
 			substringLen = rightLmsPos - leftLmsPos + 1;
-			if (substringLen <= D) {//record the starting position of current lms-substring.
-				substrings.push_back(SubstringPtr(leftLmsPos, substringLen));
+			if (substringLen <= D) {//record the starting position of current lms-substring (collected later in lean mode).
+				if (!mLean) substrings.push_back(SubstringPtr(leftLmsPos, substringLen, mPacked ? packSubstring(mS + leftLmsPos, substringLen, D) : 0));
 			}
 			else {//insert the ending position of current lms-substring into sa.
 				mSA[mBkt[mS[rightLmsPos]]--] = rightLmsPos;
@@ -255,9 +399,14 @@ void SAIS<charT>::run() {
 #endif
 
 	//sort small-length lms-substrings recorded in substrings. 
-	SubstringPtrSort<charT> substringPtrSort;
-	substringPtrSort.sBuf = mS;
-	std::sort(substrings.begin(), substrings.end(), substringPtrSort);
+	if (mPacked) {
+		radixSortSubstrings(substrings.data(), substrings.data() + substrings.size(), sizeof(charT) * D);
+	}
+	else {
+		SubstringPtrSort<charT> substringPtrSort;
+		substringPtrSort.sBuf = mS;
+		std::sort(substrings.begin(), substrings.end(), substringPtrSort);
+	}
 
 #ifdef _DEBUG_SAISM
 	std::cerr << "sort substrings in lms-chars:\n";
@@ -309,9 +458,22 @@ void SAIS<charT>::run() {
 #endif
 
 
-	n12 = substrings.size();
+	//move the sorted small-length lms-substrings next to the long ones in sa, or collect and sort them there in lean mode.
+	uint32 *shortSA = mSA + n11;
+	if (mLean) {
+		n12 = collectSubstrings(shortSA);
+		std::sort(shortSA, shortSA + n12, [this](const uint32 _a, const uint32 _b) { return compareSubstring(_a, _b) < 0; });
+	}
+	else {
+		n12 = substrings.size();
+		for (j = 0; j < n12; ++j) shortSA[j] = substrings[j].pos;
+	}
 	n1 = n11 + n12;
 
+	//two small-length lms-substrings are equal iff their keys are equal if packed.
+	auto isSameShort = [&](const uint32 _j) { return mPacked ? substrings[_j].key == substrings[_j - 1].key : 0 == compareSubstring(shortSA[_j], shortSA[_j - 1]); };
+	std::cerr << "level " << mLevel << " lms-substrings: short " << n12 << " long " << n11 - 1 << std::endl; //exclude the sentinel
+
 #ifdef _DEBUG_SAISM
 	std::cerr <<"n1: " << n1 << " n11: " << n11 << " n12: " << n12 << std::endl;
 #endif
@@ -324,7 +486,7 @@ void SAIS<charT>::run() {
 	mSA[n1 + mSA[i++] / 2] = name; //must be the sentinel
 	pre_name = name++;
 	while (i < n11 && j < n12) {
-		result = compareSubstring(mSA[i], substrings[j].pos);
+		result = compareSubstring(mSA[i], shortSA[j]);
 		if (result == -1) {
 #ifdef _DEBUG_SAISM
 			std:: cout << "rel< " << mSA[i] <<" " << std::endl;
@@ -340,23 +502,23 @@ void SAIS<charT>::run() {
 		}
 		else if (result == +1) {
 #ifdef _DEBUG_SAISM
-			std:: cout <<"rel> " << substrings[j].pos <<" " << std::endl;
+			std:: cout <<"rel> " << shortSA[j] <<" " << std::endl;
 #endif
-			mSA[n1 + substrings[j++].pos / 2] = name;
+			mSA[n1 + shortSA[j++] / 2] = name;
 			pre_name = name++;
-			while(j < n12 && 0 == compareSubstring(substrings[j].pos, substrings[j - 1].pos)){
+			while(j < n12 && isSameShort(j)){
 #ifdef _DEBUG_SAISM
-			std:: cout << "rel= " << substrings[j].pos <<" " << std::endl;
+			std:: cout << "rel= " << shortSA[j] <<" " << std::endl;
 #endif
-				mSA[n1 + substrings[j++].pos / 2] = pre_name;
+				mSA[n1 + shortSA[j++] / 2] = pre_name;
 			}
 		}
 		else {
 #ifdef _DEBUG_SAISM
-			std:: cout << "rel= " << mSA[i] <<" and " << substrings[j].pos << std::endl;
+			std:: cout << "rel= " << mSA[i] <<" and " << shortSA[j] << std::endl;
 #endif
 			mSA[n1 + mSA[i++] / 2] = name;
-			mSA[n1 + substrings[j++].pos / 2] = name;
+			mSA[n1 + shortSA[j++] / 2] = name;
 			pre_name = name++;
 			while (i < n11 && 0 == compareSubstring(mSA[i], mSA[i - 1])) {
 #ifdef _DEBUG_SAISM
@@ -364,11 +526,11 @@ void SAIS<charT>::run() {
 #endif
 				mSA[n1 + mSA[i++] / 2] = pre_name;
 			}
-			while (j < n12 && 0 == compareSubstring(substrings[j].pos, substrings[j - 1].pos)) {
+			while (j < n12 && isSameShort(j)) {
 #ifdef _DEBUG_SAISM
-			std:: cout << "rel= " << substrings[j].pos <<" " << std::endl;
+			std:: cout << "rel= " << shortSA[j] <<" " << std::endl;
 #endif
-				mSA[n1 + substrings[j++].pos / 2] = pre_name;
+				mSA[n1 + shortSA[j++] / 2] = pre_name;
 			}
 		}
 	}
@@ -388,15 +550,15 @@ void SAIS<charT>::run() {
 	}
 	while (j < n12) {
 #ifdef _DEBUG_SAISM
-			std:: cout << "2 remain: " << substrings[j].pos <<" " << std::endl;
+			std:: cout << "2 remain: " << shortSA[j] <<" " << std::endl;
 #endif
-		mSA[n1 + substrings[j++].pos / 2] = name;
+		mSA[n1 + shortSA[j++] / 2] = name;
 		pre_name = name++;
-		while (j < n12 && 0 == compareSubstring(substrings[j].pos, substrings[j - 1].pos)) {
+		while (j < n12 && isSameShort(j)) {
 #ifdef _DEBUG_SAISM
-			std:: cout << "rel= " << substrings[j].pos <<" " << std::endl;
+			std:: cout << "rel= " << shortSA[j] <<" " << std::endl;
 #endif
-			mSA[n1 + substrings[j++].pos / 2] = pre_name;
+			mSA[n1 + shortSA[j++] / 2] = pre_name;
 		}
 	}
 
@@ -405,13 +567,15 @@ void SAIS<charT>::run() {
 		if (mSA[i] != UINT32_MAX) mSA[j--] = mSA[i];
 	}
 
+	std::vector<SubstringPtr>().swap(substrings); //release before the recursion
+
 	// s1 is done now
 	uint32 *sa1 = mSA, *s1 = mSA + mNum - n1;
 
 	// stage 2: solve the reduced problem
 	// recurse if names are not yet unique
 	if (name < n1) {
-		SAIS<uint32>(s1, sa1, n1, name - 1, mLevel + 1, D_HIGH);
+		SAIS<uint32>(s1, sa1, n1, name - 1, mLevel + 1, mDHigh, mDHigh, mLean);
 	}
 	else { // generate the suffix array of s1 directly
 		for (i = 0; i < n1; i++) sa1[s1[i]] = i;
@@ -468,13 +632,13 @@ int SAIS<charT>::compareSubstring(uint32 substringA_pos, uint32 substringB_pos)
 	if (mS[substringB_pos] < mS[substringA_pos]) return +1;
 	
 	if (isLMS(substringA_pos) && isLMS(substringB_pos)) {//2 cases: S_TYPE and S_TYPE or S_TYPE and B_TYPE
-		return mT[substringB_pos] - mT[substringA_pos];
+		return getType(substringB_pos) - getType(substringA_pos);
 	}
 	else if (isLMS(substringA_pos)) {
-		return (mT[substringA_pos] == B_TYPE) ? -1 : +1;
+		return (getType(substringA_pos) == B_TYPE) ? -1 : +1;
 	}
 	else {
-		return (mT[substringB_pos] == B_TYPE) ? +1 : -1;
+		return (getType(substringB_pos) == B_TYPE) ? +1 : -1;
 	}
 }
 
@@ -2,35 +2,129 @@
 
 #include "common.h"
 #include "dsais.h"
+#include "d_tuner.h"
+#include "metrics.h"
+#include "disks.h"
 
 #include <iostream>
 #include <chrono>
 #include <fstream>
+#include <limits>
 
 
-int main(int argc, char** argv){
+/// \brief smallest offset width (in bytes) able to index the input string
+///
+/// \note Positions, ranks and names computed in the induction require _s_size + 3 distinct values.
+///
+uint8 fitOffsetWidth(const uint64 _s_size) {
+
+	if (_s_size + 3 <= std::numeric_limits<uint32>::max()) return sizeof(uint32);
+
+	if (_s_size + 3 <= static_cast<uint64>(std::numeric_limits<uint40>::max())) return sizeof(uint40);
+
+	return sizeof(uint64);
+}
+
+uint8 d_low = D_LOW; ///< D at the top level
+
+uint8 d_high = D_HIGH; ///< D at the deeper levels
+
+uint32 thread_num = 1; ///< number of threads for merging the sorted S*-substrs
+
+/// \brief choose D at the top level by sampling the input string
+///
+template<typename alphabet_type>
+uint8 tuneD(const std::string & _s_fname) {
 
-	// mount stxxl disk	
-	stxxl::config *cfg = stxxl::config::get_instance();
+	DTuner<alphabet_type> tuner(_s_fname);
 
-	stxxl::disk_config disk("stxxl.tmp", 1024 * 1024 * 1024, "syscall autogrow unlink");
+	const uint8 d = tuner.run();
+
+	std::cerr << "auto d: " << (uint32)d << " (sampled S*-substrs: " << tuner.lms_num() << ", short: " << tuner.short_num(d) << ", long: " << tuner.lms_num() - tuner.short_num(d) << ")" << std::endl;
+
+	return d;
+}
+
+/// \brief compute the SA using offset_type and output it using sa_offset_type
+///
+/// \note 32-bit characters are renamed to a dense alphabet before the computation
+///
+template<typename alphabet_type, typename offset_type, typename sa_offset_type>
+void build(const std::string & _s_fname, const std::string & _sa_fname) {
+
+	DSAIS<alphabet_type, offset_type, sa_offset_type> dsa(_s_fname, _sa_fname, d_low, d_high, thread_num);
+
+	dsa.run();
+}
 
-	disk.direct = stxxl::disk_config::DIRECT_ON;
+/// \brief dispatch on the width of the output SA
+///
+template<typename alphabet_type, typename offset_type>
+void build(const uint8 _sa_width, const std::string & _s_fname, const std::string & _sa_fname) {
 
-	cfg->add_disk(disk);
+	switch (_sa_width) {
+
+	case sizeof(uint32): build<alphabet_type, offset_type, uint32>(_s_fname, _sa_fname); break;
+
+	case sizeof(uint40): build<alphabet_type, offset_type, uint40>(_s_fname, _sa_fname); break;
+
+	default: build<alphabet_type, offset_type, uint64>(_s_fname, _sa_fname); break;
+	}
+}
+
+/// \brief dispatch on the width of offsets used for computation
+///
+template<typename alphabet_type>
+void build(const uint8 _offset_width, const uint8 _sa_width, const std::string & _s_fname, const std::string & _sa_fname) {
+
+	switch (_offset_width) {
+
+	case sizeof(uint32): build<alphabet_type, uint32>(_sa_width, _s_fname, _sa_fname); break;
+
+	case sizeof(uint40): build<alphabet_type, uint40>(_sa_width, _s_fname, _sa_fname); break;
+
+	default: build<alphabet_type, uint64>(_sa_width, _s_fname, _sa_fname); break;
+	}
+}
+
+
+int main(int argc, char** argv){
+
+	// mount stxxl disks, retrieved ahead of the other params
+	mountDisks(argc, argv);
 	
 	// statistics collection
 	stxxl::stats *Stats = stxxl::stats::get_instance();
 
 	stxxl::stats_data stats_begin(*Stats);
 
+	const file_stats_list_type file_stats_begin = getFileStats(); // for the per-disk volumes
+
 	stxxl::block_manager *bm = stxxl::block_manager::get_instance();
 
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
 	// check if input params are legal
-	if (argc != 3) {
+	if (argc < 3) {
 
 		std::cerr << "two param required: input_path and output_path.\n";
 
+		std::cerr << "optional param: --sa-width 4|5|8 (bytes per SA entry, default: the smallest one fitting the input).\n";
+
+		std::cerr << "optional param: --alphabet-width 1|4 (bytes per character, 4 for integer alphabets renamed to a dense one before the computation, default: 1).\n";
+
+		std::cerr << "optional param: --d num (threshold for short S*-substrs at the top level, one of 3, 4, 5, 6, 8, default: " << (uint32)D_LOW << ").\n";
+
+		std::cerr << "optional param: --d-high num (threshold for short S*-substrs at the deeper levels, default: " << (uint32)D_HIGH << ").\n";
+
+		std::cerr << "optional param: --auto-d (choose the threshold at the top level by sampling the input).\n";
+
+		std::cerr << "optional param: --threads num (threads for merging the sorted S*-substrs and forming the runs of the long ones, default: 1, i.e., sequential).\n";
+
+		std::cerr << DISK_USAGE;
+
+		std::cerr << "optional param: --metrics metrics_path (output measurements in JSON, or in CSV if metrics_path ends with .csv).\n";
+
 		exit(-1);
 	}	
 
@@ -39,6 +133,89 @@ int main(int argc, char** argv){
 	
 	// retrieve file name for output SA
 	std::string sa_fname(argv[2]);
+
+	// retrieve optional params
+	uint8 sa_width = 0;
+
+	uint8 alphabet_width = sizeof(uint8);
+
+	std::string metrics_fname;
+
+	bool auto_d = false;
+
+	for (int i = 3; i < argc; ++i) {
+
+		std::string param(argv[i]);
+
+		if (param == "--sa-width" && i + 1 < argc) {
+
+			const uint64 width = parseUInt(param, argv[++i]);
+
+			if (width != sizeof(uint32) && width != sizeof(uint40) && width != sizeof(uint64)) {
+
+				std::cerr << "sa width must be 4, 5 or 8.\n";
+
+				exit(-1);
+			}
+
+			sa_width = width;
+		}
+		else if (param == "--alphabet-width" && i + 1 < argc) {
+
+			const uint64 width = parseUInt(param, argv[++i]);
+
+			if (width != sizeof(uint8) && width != sizeof(uint32)) {
+
+				std::cerr << "alphabet width must be 1 or 4.\n";
+
+				exit(-1);
+			}
+
+			alphabet_width = width;
+		}
+		else if ((param == "--d" || param == "--d-high") && i + 1 < argc) {
+
+			const uint32 d = std::stoi(argv[++i]);
+
+			if (!isDCandidate(d)) {
+
+				std::cerr << "d must be 3, 4, 5, 6 or 8.\n";
+
+				exit(-1);
+			}
+
+			(param == "--d" ? d_low : d_high) = d;
+		}
+		else if (param == "--auto-d") {
+
+			auto_d = true;
+		}
+		else if (param == "--threads" && i + 1 < argc) {
+
+			thread_num = std::stoul(argv[++i]);
+
+			if (thread_num == 0) {
+
+				std::cerr << "number of threads must be positive.\n";
+
+				exit(-1);
+			}
+		}
+		else if (param == "--metrics" && i + 1 < argc) {
+
+			metrics_fname = argv[++i];
+		}
+		else if (param == "--disk" && i + 1 < argc) {
+
+			++i; // mounted already
+		}
+		else {
+
+			std::cerr << "unknown param: " << param << "\n";
+
+			exit(-1);
+		}
+	}
 	
 	// compute input string's size
 	std::fstream s_stream(s_fname, std::fstream::in);
@@ -47,16 +224,50 @@ int main(int argc, char** argv){
 
 	uint64 s_size = s_stream.tellg();
 
+	if (s_size % alphabet_width != 0) {
+
+		std::cerr << "s size is not a multiple of the alphabet width.\n";
+
+		exit(-1);
+	}
+
+	s_size /= alphabet_width; // number of characters
+
+	// choose the smallest offset type for computation, the output SA must not be narrower
+	uint8 offset_width = fitOffsetWidth(s_size);
+
+	if (sa_width == 0) sa_width = offset_width;
+
+	if (sa_width < offset_width) {
+
+		std::cerr << "sa width " << (uint32)sa_width << " is too narrow for the input, at least " << (uint32)offset_width << " required.\n";
+
+		exit(-1);
+	}
+
 	// report static information
-	std::cerr << "s fname: " << s_fname << "\nsa fname: " << sa_fname << "\ns size: " << s_size / 1024 / 1024 << " MB" << std::endl;
+	std::cerr << "s fname: " << s_fname << "\nsa fname: " << sa_fname << "\ns size: " << s_size * alphabet_width / 1024 / 1024 << " MB" << std::endl;
+
+	std::cerr << "alphabet width: " << (uint32)alphabet_width << "\noffset width: " << (uint32)offset_width << "\nsa width: " << (uint32)sa_width << std::endl;
+
+	// choose D by sampling
+	if (auto_d) {
+
+		d_low = (alphabet_width == sizeof(uint8)) ? tuneD<uint8>(s_fname) : tuneD<uint32>(s_fname);
+	}
+
+	std::cerr << "d low: " << (uint32)d_low << "\nd high: " << (uint32)d_high << "\nthreads: " << thread_num << std::endl;
 
 	// compute the SA for the given string
-	DSAIS<uint8, uint40> dsa(s_fname, sa_fname);	
+	switch (alphabet_width) {
 
-	dsa.run();
+	case sizeof(uint8): build<uint8>(offset_width, sa_width, s_fname, sa_fname); break;
+
+	default: build<uint32>(offset_width, sa_width, s_fname, sa_fname); break;
+	}
 
 	// output report
-	std::cerr << (stxxl::stats_data(*Stats) - stats_begin);
+	reportDisks(stats_begin, file_stats_begin);
 
 	uint64 pdu = bm->get_maximum_allocation(); 
 
@@ -68,6 +279,11 @@ int main(int argc, char** argv){
 
 #ifdef COLLECT_STATISTICS
 
+	for (size_t i = 0; i < levelShortNums.size(); ++i) {
+
+		std::cerr << "level " << i << " S*-substrs\t short: " << levelShortNums[i] << "\t long: " << levelLongNums[i] << std::endl;
+	}
+
 	std::cerr << "reduction pdu\t total: " << middlePDU << "\t per char: " << (double)middlePDU / s_size << std::endl;
 
 	uint64 reduction_io_volume = middleIOVolume - stats_begin.get_written_volume() - stats_begin.get_read_volume();
@@ -83,5 +299,85 @@ int main(int argc, char** argv){
 	std::cerr << "induction time\t total: " << (inductionTimer.seconds()) << "\t per char: " << (double)(inductionTimer.seconds()) / s_size << std::endl;
 
 #endif
+
+	// output measurements
+	if (!metrics_fname.empty()) {
+
+		Metrics metrics;
+
+		metrics.addString("program", "build");
+
+		metrics.addString("input", s_fname);
+
+		metrics.addInteger("input_size", s_size);
+
+		metrics.addInteger("alphabet_width", alphabet_width);
+
+		metrics.addInteger("offset_width", offset_width);
+
+		metrics.addInteger("sa_width", sa_width);
+
+		metrics.addInteger("max_mem", MAX_MEM);
+
+		metrics.addInteger("d_low", d_low);
+
+		metrics.addInteger("d_high", d_high);
+
+		metrics.addBool("auto_d", auto_d);
+
+		metrics.addInteger("threads", thread_num);
+
+		metrics.addReal("elapsed_time", std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+		addStxxlMetrics(metrics, stats_begin, s_size);
+
+		addDiskMetrics(metrics, file_stats_begin);
+
+#ifdef COLLECT_STATISTICS
+
+		metrics.addInteger("recursion_depth", levelBlockNums.size());
+
+		metrics.addInteger("block_count", levelBlockNums.empty() ? 0 : levelBlockNums[0]);
+
+		for (size_t i = 0; i < levelBlockNums.size(); ++i) {
+
+			Metrics level;
+
+			level.addInteger("level", i);
+
+			level.addInteger("block_count", levelBlockNums[i]);
+
+			level.addInteger("short_substr_count", i < levelShortNums.size() ? levelShortNums[i] : 0);
+
+			level.addInteger("long_substr_count", i < levelLongNums.size() ? levelLongNums[i] : 0);
+
+			metrics.addRecord("levels", level);
+		}
+
+		Metrics reduction, induction;
+
+		reduction.addString("name", "reduction");
+
+		reduction.addReal("wall_time", reductionTimer.seconds());
+
+		reduction.addReal("io_volume", reduction_io_volume);
+
+		reduction.addReal("peak_disk_use", middlePDU);
+
+		metrics.addRecord("phases", reduction);
+
+		induction.addString("name", "induction");
+
+		induction.addReal("wall_time", inductionTimer.seconds());
+
+		induction.addReal("io_volume", induction_io_volume);
+
+		induction.addReal("peak_disk_use", pdu);
+
+		metrics.addRecord("phases", induction);
+#endif
+
+		metrics.write(metrics_fname);
+	}
 	
 }
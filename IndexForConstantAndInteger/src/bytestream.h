@@ -5,6 +5,8 @@
 #include "namespace.h"
 #include "mycommon.h"
 
+#include <cstring>
+
 WTL_BEG_NAMESPACE
 
 class ByteStream {
@@ -24,32 +26,90 @@ public:
 	//type of uint8 block
 	typedef stxxl::typed_block<BLOCK_SIZE, uint8> block_type;
 
+	//buf_ostream copying a span of bytes into the current block by memcpy, a full block is written out as operator<< does
+	class bulk_ostream : public stxxl::buf_ostream<block_type, bid_iterator_type> {
+	public:
+		typedef stxxl::buf_ostream<block_type, bid_iterator_type> base_type;
+
+		bulk_ostream(bid_iterator_type _first_bid, stxxl::int_type _nbuffers) : base_type(_first_bid, _nbuffers) {}
+
+		//a single bounds check if the span fits in the current block
+		void write(const uint8 * _src, size_t _num) {
+			while (true) {
+				size_t avail = block_type::size - this->current_elem;
+				if (_num < avail) {
+					memcpy(this->current_blk->elem + this->current_elem, _src, _num);
+					this->current_elem += _num;
+					return;
+				}
+				memcpy(this->current_blk->elem + this->current_elem, _src, avail);
+				_src += avail, _num -= avail;
+				this->current_elem = 0;
+				this->current_blk = this->writer.write(this->current_blk, *(this->current_bid++));
+				if (_num == 0) return;
+			}
+		}
+	};
+
+	//buf_istream copying a span of bytes from the current block by memcpy, a consumed block is handed back to the prefetcher as operator>> does
+	class bulk_istream : public stxxl::buf_istream<block_type, bid_iterator_type> {
+	public:
+		typedef stxxl::buf_istream<block_type, bid_iterator_type> base_type;
+
+		bulk_istream(bid_iterator_type _begin, bid_iterator_type _end, stxxl::int_type _nbuffers) : base_type(_begin, _end, _nbuffers) {}
+
+		//a single bounds check if the span lies in the current block
+		void read(uint8 * _dst, size_t _num) {
+			while (true) {
+				size_t avail = block_type::size - this->current_elem;
+				if (_num < avail) {
+					memcpy(_dst, this->current_blk->elem + this->current_elem, _num);
+					this->current_elem += _num;
+					return;
+				}
+				memcpy(_dst, this->current_blk->elem + this->current_elem, avail);
+				_dst += avail, _num -= avail;
+				this->current_elem = 0;
+				this->prefetcher->block_consumed(this->current_blk);
+				if (_num == 0) return;
+			}
+		}
+	};
+
 	//type of uint8 buf_ostream
-	typedef stxxl::buf_ostream<block_type, bid_iterator_type> buf_ostream_type;
+	typedef bulk_ostream buf_ostream_type;
 
 	//type of uint8 buf_istream
-	typedef stxxl::buf_istream<block_type, bid_iterator_type> buf_istream_type;
+	typedef bulk_istream buf_istream_type;
 
 	//type of vector for uint8 buf_ostream
 	typedef std::vector<buf_ostream_type*> buf_ostream_vector_type;
 
-	//type of vector for uint8 buf_istream 
+	//type of vector for uint8 buf_istream
 	typedef std::vector<buf_istream_type*> buf_istream_vector_type;
 
 	//data members
-	//put data into the buf_ostream
+	//put data into the buf_ostream, the size is a compile-time constant for each record type (e.g., a tuple or uint40)
 	template<typename dataT> static buf_ostream_type& putData(buf_ostream_type & _os, const dataT & _data) {
-		for (size_t i = 0; i < sizeof(dataT) / sizeof(typename buf_ostream_type::block_type::type); ++i) {
-			_os << (((typename buf_ostream_type::block_type::type*)&_data)[i]);
-		}
+		_os.write((const uint8*)&_data, sizeof(dataT));
+		return _os;
+	}
+
+	//put _num records into the buf_ostream
+	template<typename dataT> static buf_ostream_type& putData(buf_ostream_type & _os, const dataT * _data, const size_t _num) {
+		_os.write((const uint8*)_data, sizeof(dataT) * _num);
 		return _os;
 	}
 
 	//get data from the buf_istream
-	template<typename dataT> static buf_istream_type& getData(buf_istream_type & _is, const dataT & _data) {
-		for (size_t i = 0; i < sizeof(dataT) / sizeof(typename buf_istream_type::block_type::type); ++i) {
-			_is >> (((typename buf_istream_type::block_type::type*)&_data)[i]);
-		}
+	template<typename dataT> static buf_istream_type& getData(buf_istream_type & _is, dataT & _data) {
+		_is.read((uint8*)&_data, sizeof(dataT));
+		return _is;
+	}
+
+	//get _num records from the buf_istream
+	template<typename dataT> static buf_istream_type& getData(buf_istream_type & _is, dataT * _data, const size_t _num) {
+		_is.read((uint8*)_data, sizeof(dataT) * _num);
 		return _is;
 	}
 };
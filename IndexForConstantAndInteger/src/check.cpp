@@ -1,33 +1,47 @@
 #include "common.h"
+#include "metrics.h"
+#include "disks.h"
 #include "checker.h"
 
 #include <iostream>
 #include <chrono>
 #include <fstream>
 
-int main(int argc, char** argv){
+/// \brief check the SA whose entries are stored using offset_type
+///
+template<typename offset_type>
+bool check(const std::string & _s_fname, const std::string & _sa_fname) {
 
-	// mount stxxl disk	
-	stxxl::config *cfg = stxxl::config::get_instance();
+	Checker<uint8, offset_type> checker(_s_fname, _sa_fname);
 
-	stxxl::disk_config disk("stxxl.tmp", 1024 * 1024 * 1024, "syscall autogrow unlink");
+	return checker.run();
+}
 
-	disk.direct = stxxl::disk_config::DIRECT_ON;
+int main(int argc, char** argv){
 
-	cfg->add_disk(disk);
+	// mount stxxl disks, retrieved ahead of the other params
+	mountDisks(argc, argv);
 
 	// statistcs collection
 	stxxl::stats *Stats = stxxl::stats::get_instance();
 
 	stxxl::stats_data stats_begin(*Stats);
 
+	const file_stats_list_type file_stats_begin = getFileStats(); // for the per-disk volumes
+
 	stxxl::block_manager * bm = stxxl::block_manager::get_instance();
+
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
 	
 	// check if input params are legal
-	if (argc != 3) {
+	if (argc < 3) {
 
 		std::cerr << "two param required: input_path and output_path.\n";
 
+		std::cerr << DISK_USAGE;
+
+		std::cerr << "optional param: --metrics metrics_path (output measurements in JSON, or in CSV if metrics_path ends with .csv).\n";
+
 		exit(-1);
 	}	
 
@@ -37,6 +51,29 @@ int main(int argc, char** argv){
 	// retrieve file name for output SA
 	std::string sa_fname(argv[2]);
 
+	// retrieve optional params
+	std::string metrics_fname;
+
+	for (int i = 3; i < argc; ++i) {
+
+		std::string param(argv[i]);
+
+		if (param == "--metrics" && i + 1 < argc) {
+
+			metrics_fname = argv[++i];
+		}
+		else if (param == "--disk" && i + 1 < argc) {
+
+			++i; // mounted already
+		}
+		else {
+
+			std::cerr << "unknown param: " << param << "\n";
+
+			exit(-1);
+		}
+	}
+
 	// compute input string's size
 	std::fstream s_stream(s_fname, std::fstream::in);
 
@@ -44,13 +81,38 @@ int main(int argc, char** argv){
 
 	uint64 s_size = s_stream.tellg();
 	
+	// infer the width of SA entries from the file sizes
+	std::fstream sa_stream(sa_fname, std::fstream::in);
+
+	sa_stream.seekg(0, std::ios_base::end);
+
+	uint64 sa_size = sa_stream.tellg();
+
+	if (s_size == 0 || sa_size % s_size != 0) {
+
+		std::cerr << "sa size does not match s size.\n";
+
+		exit(-1);
+	}
+
 	// check the SA for the given string
-	Checker<uint8, uint40> checker(s_fname, sa_fname);	
+	bool is_right = false;
+
+	switch (sa_size / s_size) {
+
+	case sizeof(uint32): is_right = check<uint32>(s_fname, sa_fname); break;
 
-	std::cerr << (checker.run() ? "right" : "wrong")<< std::endl;
+	case sizeof(uint40): is_right = check<uint40>(s_fname, sa_fname); break;
+
+	case sizeof(uint64): is_right = check<uint64>(s_fname, sa_fname); break;
+
+	default: std::cerr << "sa width must be 4, 5 or 8.\n"; exit(-1);
+	}
+
+	std::cerr << (is_right ? "right" : "wrong") << std::endl;
 
 	// output report
-	std::cerr << (stxxl::stats_data(*Stats) - stats_begin);
+	reportDisks(stats_begin, file_stats_begin);
 
 	uint64 pdu = bm->get_maximum_allocation();
 
@@ -60,5 +122,31 @@ int main(int argc, char** argv){
 
 	std::cerr << "io\t total: " << io_volume << "\t per char: " << (double)io_volume / s_size << std::endl;
 
+	// output measurements
+	if (!metrics_fname.empty()) {
+
+		Metrics metrics;
+
+		metrics.addString("program", "check");
+
+		metrics.addString("input", s_fname);
+
+		metrics.addInteger("input_size", s_size);
+
+		metrics.addInteger("alphabet_width", sizeof(uint8));
+
+		metrics.addInteger("sa_width", sa_size / s_size);
+
+		metrics.addInteger("max_mem", MAX_MEM);
+
+		metrics.addBool("right", is_right);
+
+		metrics.addReal("elapsed_time", std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+		addStxxlMetrics(metrics, stats_begin, s_size);
+
+		addDiskMetrics(metrics, file_stats_begin);
 
+		metrics.write(metrics_fname);
+	}
 }
@@ -12,6 +12,11 @@
 #include <limits>
 #include <vector>
 #include <utility>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cctype>
+#include <stdexcept>
 
 // alias for integral types
 using uint8 = stxxl::uint8;
@@ -24,6 +29,29 @@ using uint40 = stxxl::uint40;
 
 using uint64 = stxxl::uint64;
 
+/// \brief parse the unsigned integer given to a command-line param, exit if it is not a number or out of range
+///
+inline uint64 parseUInt(const std::string & _param, const std::string & _value) {
+
+	size_t len = 0;
+
+	uint64 val = 0;
+
+	if (!_value.empty() && std::isdigit(static_cast<unsigned char>(_value[0]))) {
+
+		try { val = std::stoull(_value, &len); } catch (const std::exception &) { len = 0; }
+	}
+
+	if (len == 0 || len != _value.size()) {
+
+		std::cerr << "illegal value for " << _param << ": " << _value << "\n";
+
+		exit(-1);
+	}
+
+	return val;
+}
+
 // L-type or S-type
 constexpr uint8 L_TYPE = 0;
 
@@ -39,6 +67,16 @@ constexpr uint8 D_LOW = 4;
 
 constexpr uint8 D_HIGH = 4;
 
+// D selectable at runtime, each candidate is a precompiled instantiation of DSAComputation (in ascending order)
+constexpr uint8 D_CANDIDATES[] = {3, 4, 5, 6, 8};
+
+// auto-tuning of D: the smallest candidate making at least D_AUTO_COVERAGE of the sampled S*-substrs short
+constexpr double D_AUTO_COVERAGE = 0.5;
+
+constexpr uint64 D_SAMPLE_NUM = 64; // number of sampled chunks
+
+constexpr uint64 D_SAMPLE_LEN = 1024 * 1024; // number of characters in a sampled chunk
+
 // memory allocation
 constexpr uint64 K_512 = 512 * 1024;
 
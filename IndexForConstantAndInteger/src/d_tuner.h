@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file d_tuner.h
+/// \brief Choose the threshold D for the short/long split of S*-substrs by sampling the input string.
+///
+/// D_SAMPLE_NUM chunks of D_SAMPLE_LEN characters, evenly spaced over the input, are read.
+/// The S*-substrs completely contained in a chunk are classified by their lengths,
+/// and the smallest candidate D making at least D_AUTO_COVERAGE of them short is chosen.
+/// If no candidate reaches the coverage (e.g., long runs), increasing D gains nothing and the smallest candidate is chosen.
+///////////////////////////////////////////////////////////
+
+#ifndef _D_TUNER_H
+#define _D_TUNER_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+/// \brief check if D is one of the precompiled candidates
+///
+inline bool isDCandidate(const uint32 _d) {
+
+	for (uint8 i = 0; i < sizeof(D_CANDIDATES); ++i) {
+
+		if (D_CANDIDATES[i] == _d) return true;
+	}
+
+	return false;
+}
+
+/// \brief sample the input string to choose D
+///
+template<typename alphabet_type>
+class DTuner{
+
+private:
+
+	const std::string m_s_fname;
+
+	std::vector<uint64> m_len_cnt; ///< number of sampled S*-substrs of each length, the last one counts those no shorter
+
+	uint64 m_lms_num; ///< number of sampled S*-substrs
+
+	uint8 m_d; ///< chosen D
+
+public:
+
+	/// \brief ctor
+	///
+	DTuner(const std::string & _s_fname) : m_s_fname(_s_fname), m_len_cnt(D_CANDIDATES[sizeof(D_CANDIDATES) - 1] + 2, 0), m_lms_num(0), m_d(D_CANDIDATES[0]) {}
+
+	/// \brief sample the input string and choose D
+	///
+	uint8 run() {
+
+		std::ifstream fin(m_s_fname, std::ios_base::in | std::ios_base::binary);
+
+		fin.seekg(0, std::ios_base::end);
+
+		const uint64 s_len = fin.tellg() / sizeof(alphabet_type);
+
+		const uint64 chunk_num = std::max(std::min(D_SAMPLE_NUM, s_len / D_SAMPLE_LEN), uint64(1));
+
+		const uint64 chunk_len = std::min(D_SAMPLE_LEN, s_len);
+
+		std::vector<alphabet_type> chunk(chunk_len);
+
+		for (uint64 i = 0; i < chunk_num; ++i) {
+
+			fin.seekg((s_len - chunk_len) / chunk_num * i * sizeof(alphabet_type), std::ios_base::beg);
+
+			fin.read((char*)chunk.data(), chunk_len * sizeof(alphabet_type));
+
+			scanChunk(chunk);
+		}
+
+		uint64 short_num = 0;
+
+		for (uint8 i = 0; i < sizeof(D_CANDIDATES); ++i) {
+
+			for (uint32 len = (i == 0 ? 0 : D_CANDIDATES[i - 1] + 1); len <= D_CANDIDATES[i]; ++len) short_num += m_len_cnt[len];
+
+			if (short_num >= D_AUTO_COVERAGE * m_lms_num) {
+
+				m_d = D_CANDIDATES[i];
+
+				break;
+			}
+		}
+
+		return m_d;
+	}
+
+	/// \brief number of sampled S*-substrs
+	///
+	uint64 lms_num() const {
+
+		return m_lms_num;
+	}
+
+	/// \brief number of sampled S*-substrs no longer than _d
+	///
+	uint64 short_num(const uint8 _d) const {
+
+		uint64 num = 0;
+
+		for (uint32 len = 0; len <= _d && len < m_len_cnt.size() - 1; ++len) num += m_len_cnt[len];
+
+		return num;
+	}
+
+private:
+
+	/// \brief classify the S*-substrs completely contained in the chunk, scanning from right to left
+	///
+	void scanChunk(const std::vector<alphabet_type> & _chunk) {
+
+		if (_chunk.size() < 2) return;
+
+		uint8 last_t = L_TYPE; // the type of the rightmost character is unknown, so the substr ending at the first S*-character found is dropped
+
+		uint64 lms_end_pos = 0; // 0 if no S*-character found yet
+
+		for (uint64 i = _chunk.size() - 1; i > 0; --i) {
+
+			const uint8 cur_t = (_chunk[i - 1] < _chunk[i] || (_chunk[i - 1] == _chunk[i] && last_t == S_TYPE)) ? S_TYPE : L_TYPE;
+
+			if (cur_t == L_TYPE && last_t == S_TYPE) { // _chunk[i] is S*-type
+
+				if (lms_end_pos != 0) {
+
+					++m_len_cnt[std::min(lms_end_pos - i + 1, uint64(m_len_cnt.size() - 1))], ++m_lms_num;
+				}
+
+				lms_end_pos = i;
+			}
+
+			last_t = cur_t;
+		}
+	}
+};
+
+#endif // _D_TUNER_H
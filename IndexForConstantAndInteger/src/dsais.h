@@ -12,6 +12,7 @@
 #include <string>
 #include <fstream>
 #include <cassert>
+#include <algorithm>
 
 //#define TEST_DEBUG1 // output
 //#define TEST_DEBUG2 // assertion
@@ -28,14 +29,25 @@ extern stxxl::timer reductionTimer = 0;
 
 extern stxxl::timer inductionTimer = 0;
 
+std::vector<uint64> levelBlockNums; ///< number of blocks at each recursion level
+
+std::vector<uint64> levelShortNums; ///< number of short S*-substrs at each recursion level
+
+std::vector<uint64> levelLongNums; ///< number of long S*-substrs at each recursion level
+
 #endif
 
 template<typename alphabet_type, typename offset_type, uint8 D>
 class DSAComputation;
 
+template<typename alphabet_type, typename offset_type>
+void computeDSA(const uint8 _d, const uint8 _d_high, typename ExVector<alphabet_type>::vector *& _s, const uint32 _level, typename ExVector<offset_type>::vector *& _sa_reverse, const uint32 _thread_num = 1, const uint64 _max_alpha = 0);
+
 /// \brief portal to DSAComputation
 ///
-template<typename alphabet_type, typename offset_type>
+/// \note offset_type is used for computation, sa_offset_type for the output SA (not narrower than offset_type)
+///
+template<typename alphabet_type, typename offset_type, typename sa_offset_type = offset_type>
 class DSAIS{
 
 private:
@@ -44,17 +56,27 @@ private:
 
 	typedef typename ExVector<offset_type>::vector offset_vector_type;
 
+	typedef typename ExVector<sa_offset_type>::vector sa_offset_vector_type;
+
 private:
 
 	const std::string m_s_fname; ///< input string file name
 	
 	const std::string m_sa_fname; ///< output SA file name
 
+	const uint8 m_d_low; ///< D at the top level
+
+	const uint8 m_d_high; ///< D at the deeper levels
+
+	const uint32 m_thread_num; ///< number of threads
+
 public:
 
 	/// \brief ctor 
 	///
-	DSAIS(const std::string & _s_fname, const std::string & _sa_fname) : m_s_fname(_s_fname), m_sa_fname(_sa_fname) {}
+	/// \note _d_low and _d_high must be in D_CANDIDATES
+	DSAIS(const std::string & _s_fname, const std::string & _sa_fname, const uint8 _d_low = D_LOW, const uint8 _d_high = D_HIGH, const uint32 _thread_num = 1) : 
+		m_s_fname(_s_fname), m_sa_fname(_sa_fname), m_d_low(_d_low), m_d_high(_d_high), m_thread_num(_thread_num) {}
 
 	/// \brief create DSAComputation
 	///
@@ -68,22 +90,31 @@ public:
 
 		alphabet_vector_type *s_origin = new alphabet_vector_type(s_file);
 
-		typename alphabet_vector_type::bufreader_type s_origin_reader(*s_origin);
-
 		alphabet_vector_type *s_target = new alphabet_vector_type(); s_target->resize(s_origin->size() + 1); // append a sentinel
 
-		typename alphabet_vector_type::bufwriter_type s_target_writer(*s_target);
-
 		uint64 s_origin_len = s_origin->size();
 
-		for (; !s_origin_reader.empty(); ++s_origin_reader) {
+		uint64 max_alpha = 0; // unknown
+
+		if (sizeof(alphabet_type) >= sizeof(uint32)) { // integer alphabet, rename the characters to a dense alphabet
 
-			s_target_writer << *s_origin_reader;
+			max_alpha = compactAlphabet(s_origin, s_target);
 		}
+		else {
+
+			typename alphabet_vector_type::bufreader_type s_origin_reader(*s_origin);
+
+			typename alphabet_vector_type::bufwriter_type s_target_writer(*s_target);
+
+			for (; !s_origin_reader.empty(); ++s_origin_reader) {
+
+				s_target_writer << *s_origin_reader;
+			}
 	
-		s_target_writer << alphabet_type(0);
+			s_target_writer << alphabet_type(0);
 
-		s_target_writer.finish();
+			s_target_writer.finish();
+		}
 
 		// clear
 		delete s_origin; s_origin = nullptr;
@@ -93,9 +124,7 @@ public:
 		// compute sa_reverse
 		offset_vector_type *sa_reverse = nullptr;
 	
-		DSAComputation<alphabet_type, offset_type, D_LOW> dsac(s_target, 0, sa_reverse);
-	
-		dsac.run();
+		computeDSA<alphabet_type, offset_type>(m_d_low, m_d_high, s_target, 0, sa_reverse, m_thread_num, max_alpha);
 	
 		// clear
 		delete s_target; s_target = nullptr;
@@ -106,15 +135,15 @@ public:
 		stxxl::syscall_file *sa_file = new stxxl::syscall_file(m_sa_fname, 
 						stxxl::syscall_file::CREAT | stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
 	
-		offset_vector_type *sa = new offset_vector_type(sa_file); sa->resize(s_origin_len);
+		sa_offset_vector_type *sa = new sa_offset_vector_type(sa_file); sa->resize(s_origin_len);
 	
-		typename offset_vector_type::bufwriter_type sa_writer(*sa);
+		typename sa_offset_vector_type::bufwriter_type sa_writer(*sa);
 
 		++sa_reader; // skip the sentinel
 	
 		for (; !sa_reader.empty(); ++sa_reader) {
 
-			sa_writer << *sa_reader;
+			sa_writer << sa_offset_type(static_cast<uint64>(*sa_reader));
 		}
 		
 		sa_writer.finish();
@@ -131,6 +160,162 @@ public:
 #endif
 		return;
 	}	
+
+private:
+
+	/// \brief copy the input string with the characters renamed by their ranks among the distinct ones, append a sentinel
+	///
+	/// \return the largest name
+	///
+	/// \note Names start from 1, 0 is reserved for the sentinel. 
+	/// The distinct characters are marked in a bitmap sized by the largest character (512 MB for the full 32-bit range), 
+	/// together with the number of distinct characters preceding each word of the bitmap (256 MB). 
+	/// If the two exceed MAX_MEM, the characters are renamed by sorting instead.
+	uint64 compactAlphabet(alphabet_vector_type * _s_origin, alphabet_vector_type * _s_target) {
+
+		// find the largest character
+		uint64 max_ch = 0;
+
+		{
+			typename alphabet_vector_type::bufreader_type s_origin_reader(*_s_origin);
+
+			for (; !s_origin_reader.empty(); ++s_origin_reader) {
+
+				max_ch = std::max(max_ch, static_cast<uint64>(*s_origin_reader));
+			}
+		}
+
+		const uint64 word_num = (max_ch >> 6) + 1;
+
+		if (word_num * (sizeof(uint64) + sizeof(uint32)) > MAX_MEM) return compactAlphabetBySort(_s_origin, _s_target);
+
+		// mark the distinct characters
+		std::vector<uint64> bitmap(word_num, 0);
+
+		{
+			typename alphabet_vector_type::bufreader_type s_origin_reader(*_s_origin);
+
+			for (; !s_origin_reader.empty(); ++s_origin_reader) {
+
+				const uint64 ch = static_cast<uint64>(*s_origin_reader);
+
+				bitmap[ch >> 6] |= uint64(1) << (ch & 63);
+			}
+		}
+
+		// count the distinct characters preceding each word
+		std::vector<uint32> ranks(word_num);
+
+		uint64 name_num = 0;
+
+		for (size_t i = 0; i < bitmap.size(); ++i) {
+
+			ranks[i] = static_cast<uint32>(name_num), name_num += __builtin_popcountll(bitmap[i]);
+		}
+
+		if (name_num >= static_cast<uint64>(std::numeric_limits<uint32>::max())) { // names are counted in uint32
+
+			std::cerr << "too many distinct characters: " << name_num << "\n";
+
+			exit(-1);
+		}
+
+		// rename
+		typename alphabet_vector_type::bufreader_type s_origin_reader(*_s_origin);
+
+		typename alphabet_vector_type::bufwriter_type s_target_writer(*_s_target);
+
+		for (; !s_origin_reader.empty(); ++s_origin_reader) {
+
+			const uint64 ch = static_cast<uint64>(*s_origin_reader);
+
+			const uint64 name = ranks[ch >> 6] + __builtin_popcountll(bitmap[ch >> 6] & ((uint64(1) << (ch & 63)) - 1)) + 1;
+
+			s_target_writer << alphabet_type(name);
+		}
+
+		s_target_writer << alphabet_type(0);
+
+		s_target_writer.finish();
+
+		return name_num;
+	}
+
+	/// \brief rename the characters as compactAlphabet does, using external memory
+	///
+	/// <ch, pos> are sorted by ch to assign the names, <pos, name> are sorted back by pos to write the renamed string.
+	uint64 compactAlphabetBySort(alphabet_vector_type * _s_origin, alphabet_vector_type * _s_target) {
+
+		typedef Pair<alphabet_type, offset_type> ch_pair_type;
+
+		typedef TupleAscCmp2<ch_pair_type> ch_pair_comparator_type; // sort by <ch, pos> in ascending order
+
+		typedef typename ExSorter<ch_pair_type, ch_pair_comparator_type>::sorter ch_sorter_type;
+
+		typedef Pair<offset_type, alphabet_type> name_pair_type;
+
+		typedef TupleAscCmp1<name_pair_type> name_pair_comparator_type; // sort by pos in ascending order
+
+		typedef typename ExSorter<name_pair_type, name_pair_comparator_type>::sorter name_sorter_type;
+
+		// sort by characters
+		ch_sorter_type *ch_sorter = new ch_sorter_type(ch_pair_comparator_type(), MAX_MEM / 2);
+
+		{
+			typename alphabet_vector_type::bufreader_type s_origin_reader(*_s_origin);
+
+			for (offset_type pos = 0; !s_origin_reader.empty(); ++s_origin_reader, ++pos) {
+
+				ch_sorter->push(ch_pair_type(*s_origin_reader, pos));
+			}
+		}
+
+		ch_sorter->sort();
+
+		// assign names
+		name_sorter_type *name_sorter = new name_sorter_type(name_pair_comparator_type(), MAX_MEM / 2);
+
+		uint64 name_num = 0;
+
+		alphabet_type pre_ch = alphabet_type(0);
+
+		for (; !ch_sorter->empty(); ++(*ch_sorter)) {
+
+			if (name_num == 0 || (*ch_sorter)->first != pre_ch) {
+
+				if (++name_num >= static_cast<uint64>(std::numeric_limits<uint32>::max())) { // names are counted in uint32
+
+					std::cerr << "too many distinct characters: " << name_num << "\n";
+
+					exit(-1);
+				}
+
+				pre_ch = (*ch_sorter)->first;
+			}
+
+			name_sorter->push(name_pair_type((*ch_sorter)->second, alphabet_type(name_num)));
+		}
+
+		delete ch_sorter; ch_sorter = nullptr;
+
+		// rename
+		name_sorter->sort();
+
+		typename alphabet_vector_type::bufwriter_type s_target_writer(*_s_target);
+
+		for (; !name_sorter->empty(); ++(*name_sorter)) {
+
+			s_target_writer << (*name_sorter)->second;
+		}
+
+		s_target_writer << alphabet_type(0);
+
+		s_target_writer.finish();
+
+		delete name_sorter; name_sorter = nullptr;
+
+		return name_num;
+	}
 };
 
 /// \brief compute SA by DSA-IS
@@ -298,6 +483,12 @@ private:
 	const uint32 m_level; ///< recursion level
 
 	offset_vector_type *& m_sa_reverse; ///< output SA
+
+	const uint8 m_d_high; ///< D for the recursion
+
+	const uint32 m_thread_num; ///< number of threads
+
+	const uint64 m_max_alpha; ///< largest character if the alphabet is known to be dense (e.g., compacted by DSAIS), 0 if unknown
 	
 	std::vector<alphabet_vector_type*> m_short_ch_seqs; ///< characters for short S*-substrs in sorted order (blockwise)
 
@@ -332,7 +523,7 @@ private:
 
 public:
 
-	DSAComputation(alphabet_vector_type *& _s, const uint32 _level, offset_vector_type *& _sa_reverse);
+	DSAComputation(alphabet_vector_type *& _s, const uint32 _level, offset_vector_type *& _sa_reverse, const uint8 _d_high = D_HIGH, const uint32 _thread_num = 1, const uint64 _max_alpha = 0);
 
 	void run();
 
@@ -356,6 +547,8 @@ public:
 
 	void formatMultiBlock(const BlockInfo & _block_info, alphabet_type *_block, uint32 *_fblock, uint32 & _max_alpha);
 
+	bool isFormatRequired(const BlockInfo & _block_info) const;
+
 	void sortLongSStarGlobal();
 
 	bool mergeSortedSStarGlobal();
@@ -376,9 +569,9 @@ public:
 /// \brief ctor 
 ///
 template<typename alphabet_type, typename offset_type, uint8 D>
-DSAComputation<alphabet_type, offset_type, D>::DSAComputation(alphabet_vector_type *& _s, const uint32 _level, offset_vector_type *& _sa_reverse) : ALPHA_MAX(std::numeric_limits<alphabet_type>::max()), ALPHA_MIN(std::numeric_limits<alphabet_type>::min()),
+DSAComputation<alphabet_type, offset_type, D>::DSAComputation(alphabet_vector_type *& _s, const uint32 _level, offset_vector_type *& _sa_reverse, const uint8 _d_high, const uint32 _thread_num, const uint64 _max_alpha) : ALPHA_MAX(std::numeric_limits<alphabet_type>::max()), ALPHA_MIN(std::numeric_limits<alphabet_type>::min()),
 	OFFSET_MAX(std::numeric_limits<offset_type>::max()), OFFSET_MIN(std::numeric_limits<offset_type>::min()),
-	m_s(_s), m_s_len(m_s->size()), m_level(_level), m_sa_reverse(_sa_reverse){}
+	m_s(_s), m_s_len(m_s->size()), m_level(_level), m_sa_reverse(_sa_reverse), m_d_high(_d_high), m_thread_num(_thread_num), m_max_alpha(_max_alpha){}
 
 
 /// \brief run
@@ -433,9 +626,7 @@ void DSAComputation<alphabet_type, offset_type, D>::run() {
 			std::cerr << "recurse in EM\n";
 #endif
 
-			DSAComputation<offset_type, offset_type, D_HIGH> dsac_recurse(m_s1, m_level + 1, sa1_reverse);
-
-			dsac_recurse.run();
+			computeDSA<offset_type, offset_type>(m_d_high, m_d_high, m_s1, m_level + 1, sa1_reverse, m_thread_num);
 		}
 	}
 
@@ -564,6 +755,13 @@ uint64 DSAComputation<alphabet_type, offset_type, D>::partitionS() {
 
 	compute_block_id_of_samplings(); // compute block_id for samplings
 
+#ifdef COLLECT_STATISTICS
+
+	if (levelBlockNums.size() <= m_level) levelBlockNums.resize(m_level + 1, 0);
+
+	levelBlockNums[m_level] = m_blocks_info.size();
+#endif
+
 	return lms_num;
 }
 
@@ -647,7 +845,7 @@ void DSAComputation<alphabet_type, offset_type, D>::sortSStarBlock(const BlockIn
 
 	if (_block_info.is_multi() == true) {
 
-		if (sizeof(alphabet_type) <= sizeof(uint32)) { // no need to format input
+		if (!isFormatRequired(_block_info)) { // no need to format input
 
 			sortSStarMultiBlock<false>(_block_info);
 		}
@@ -734,7 +932,7 @@ void DSAComputation<alphabet_type, offset_type, D>::sortSStarMultiBlock(const Bl
 			s[i] = *it;
 		}
 
-		max_alpha = ALPHA_MAX;
+		max_alpha = (m_max_alpha != 0) ? m_max_alpha : static_cast<uint64>(ALPHA_MAX);
 	}
 
 	char *t_buf = new char[block_size / 8 + 1]; BitWrapper t(t_buf); // L & S type array
@@ -1051,6 +1249,18 @@ void DSAComputation<alphabet_type, offset_type, D>::formatMultiBlock(const Block
 	return;
 }
 
+/// \brief check if a multi-block must be formatted before inducing in RAM
+///
+/// \note Characters index the buckets directly if the alphabet is small, 
+/// or if it is dense and no larger than the block (then the bucket array is no larger than the formatted block).
+template<typename alphabet_type, typename offset_type, uint8 D>
+bool DSAComputation<alphabet_type, offset_type, D>::isFormatRequired(const BlockInfo & _block_info) const {
+
+	if (sizeof(alphabet_type) < sizeof(uint32)) return false;
+
+	return m_max_alpha == 0 || m_max_alpha >= _block_info.m_size;
+}
+
 /// \brief sort long S*-substrs using external memory
 ///
 template<typename alphabet_type, typename offset_type, uint8 D>
@@ -1061,9 +1271,9 @@ void DSAComputation<alphabet_type, offset_type, D>::sortLongSStarGlobal() {
 
 	typedef TupleAscCmp2<pair_type> pair_comparator_type; // sort by <ch, pos> in ascending order
 
-	typedef typename ExSorter<pair_type, pair_comparator_type>::sorter sorter_type;
+	typedef ParallelSorter<pair_type, pair_comparator_type> sorter_type;
 
-	sorter_type *sorter_lms = new sorter_type(pair_comparator_type(), MAX_MEM / 2);
+	sorter_type *sorter_lms = new sorter_type(pair_comparator_type(), MAX_MEM / 2, m_thread_num); // runs are formed by m_thread_num threads
 
 	typename alphabet_vector_type::bufreader_reverse_type s_rev_reader(*m_s);
 
@@ -1522,7 +1732,21 @@ bool DSAComputation<alphabet_type, offset_type, D>::mergeSortedSStarGlobal() {
 	str_sorter_type str_sorter = str_sorter_type(m_short_ch_seqs, m_short_len_seqs, m_short_pos_seqs, 
 						m_long_ch_seqs, m_long_pos_seq, m_long_aux_seq, blocks_beg_pos);
 
-	bool is_unique = str_sorter.process(m_s1, m_s->size());
+#ifdef COLLECT_STATISTICS
+
+	if (levelShortNums.size() <= m_level) levelShortNums.resize(m_level + 1, 0), levelLongNums.resize(m_level + 1, 0);
+
+	levelShortNums[m_level] = levelLongNums[m_level] = 0;
+
+	for (uint8 i = 0; i < m_blocks_info.size() - 1; ++i) {
+
+		levelShortNums[m_level] += m_short_len_seqs[i]->size();
+
+		levelLongNums[m_level] += m_long_ch_seqs[i]->size() / D;
+	}
+#endif
+
+	bool is_unique = str_sorter.process(m_s1, m_s->size(), m_thread_num);
 
 	// clear
 	delete m_long_aux_seq; m_long_aux_seq = nullptr;
@@ -1638,7 +1862,7 @@ void DSAComputation<alphabet_type, offset_type, D>::sortSuffixGlobal(offset_vect
 
 		if (m_blocks_info[i].is_multi()) {
 
-			if (sizeof(alphabet_type) <= sizeof(uint32)) { 
+			if (!isFormatRequired(m_blocks_info[i])) { 
 			
 				sortSuffixMultiBlock<false>(m_blocks_info[i]); 
 			}
@@ -1789,7 +2013,7 @@ void DSAComputation<alphabet_type, offset_type, D>::sortSuffixMultiBlock(const B
 			s[i] = *it;
 		}
 
-		max_alpha = ALPHA_MAX;
+		max_alpha = (m_max_alpha != 0) ? m_max_alpha : static_cast<uint64>(ALPHA_MAX);
 	}
 
 	// compute t and sort S*-suffixes
@@ -2657,4 +2881,29 @@ void DSAComputation<alphabet_type, offset_type, D>::mergeSortedSuffixGlobal() {
 #endif
 }
 
+/// \brief run DSAComputation with D chosen at runtime among D_CANDIDATES
+///
+template<typename alphabet_type, typename offset_type>
+void computeDSA(const uint8 _d, const uint8 _d_high, typename ExVector<alphabet_type>::vector *& _s, const uint32 _level, typename ExVector<offset_type>::vector *& _sa_reverse, const uint32 _thread_num, const uint64 _max_alpha) {
+
+	switch (_d) {
+
+	case 3: { DSAComputation<alphabet_type, offset_type, 3> dsac(_s, _level, _sa_reverse, _d_high, _thread_num, _max_alpha); dsac.run(); break; }
+
+	case 4: { DSAComputation<alphabet_type, offset_type, 4> dsac(_s, _level, _sa_reverse, _d_high, _thread_num, _max_alpha); dsac.run(); break; }
+
+	case 5: { DSAComputation<alphabet_type, offset_type, 5> dsac(_s, _level, _sa_reverse, _d_high, _thread_num, _max_alpha); dsac.run(); break; }
+
+	case 6: { DSAComputation<alphabet_type, offset_type, 6> dsac(_s, _level, _sa_reverse, _d_high, _thread_num, _max_alpha); dsac.run(); break; }
+
+	case 8: { DSAComputation<alphabet_type, offset_type, 8> dsac(_s, _level, _sa_reverse, _d_high, _thread_num, _max_alpha); dsac.run(); break; }
+
+	default:
+
+		std::cerr << "D = " << (uint32)_d << " is not precompiled.\n";
+
+		exit(-1);
+	}
+}
+
 #endif
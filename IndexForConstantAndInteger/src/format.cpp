@@ -1,4 +1,6 @@
 #include "common.h"
+#include "metrics.h"
+#include "disks.h"
 
 #include <iostream>
 #include <chrono>
@@ -9,20 +11,25 @@
 
 int main(int argc, char** argv){
 
-	// mount stxxl disk	
-	stxxl::config *cfg = stxxl::config::get_instance();
+	// mount stxxl disks, retrieved ahead of the other params
+	mountDisks(argc, argv);
 
-	stxxl::disk_config disk("stxxl.tmp", 1024 * 1024 * 1024, "syscall autogrow unlink");
+	// statistics collection
+	stxxl::stats_data stats_begin(*stxxl::stats::get_instance());
 
-	disk.direct = stxxl::disk_config::DIRECT_ON;
+	const file_stats_list_type file_stats_begin = getFileStats(); // for the per-disk volumes
 
-	cfg->add_disk(disk);
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
 	
 	// check if input params are legal
-	if (argc != 3) {
+	if (argc < 3) {
 
 		std::cerr << "two param required: input_path and output_path.\n";
 
+		std::cerr << DISK_USAGE;
+
+		std::cerr << "optional param: --metrics metrics_path (output measurements in JSON, or in CSV if metrics_path ends with .csv).\n";
+
 		exit(-1);
 	}	
 
@@ -31,9 +38,65 @@ int main(int argc, char** argv){
 	
 	// retrieve file name for output SA
 	std::string s_target_fname(argv[2]);
+
+	// retrieve optional params
+	std::string metrics_fname;
+
+	for (int i = 3; i < argc; ++i) {
+
+		std::string param(argv[i]);
+
+		if (param == "--metrics" && i + 1 < argc) {
+
+			metrics_fname = argv[++i];
+		}
+		else if (param == "--disk" && i + 1 < argc) {
+
+			++i; // mounted already
+		}
+		else {
+
+			std::cerr << "unknown param: " << param << "\n";
+
+			exit(-1);
+		}
+	}
 	
 	// compute the SA for the given string
 	Formatter<uint8> formatter(s_fname, s_target_fname);	
 
 	formatter.run();
+
+	// output report
+	reportDisks(stats_begin, file_stats_begin);
+
+	// output measurements
+	if (!metrics_fname.empty()) {
+
+		std::fstream s_stream(s_fname, std::fstream::in);
+
+		s_stream.seekg(0, std::ios_base::end);
+
+		uint64 s_size = s_stream.tellg();
+
+		Metrics metrics;
+
+		metrics.addString("program", "format");
+
+		metrics.addString("input", s_fname);
+
+		metrics.addInteger("input_size", s_size);
+
+		metrics.addInteger("alphabet_width", sizeof(uint8));
+
+		metrics.addInteger("max_mem", MAX_MEM);
+
+		metrics.addReal("elapsed_time", std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+		addStxxlMetrics(metrics, stats_begin, s_size);
+
+		addDiskMetrics(metrics, file_stats_begin);
+
+		metrics.write(metrics_fname);
+	}
 }
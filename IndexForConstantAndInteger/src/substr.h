@@ -5,9 +5,18 @@
 
 #include "io.h"
 
+#include <array>
+#include <limits>
+#include <cassert>
+
 #if _MSC_VER
 #pragma pack(push, 1)
 #endif
+/// \brief an S*-substr (or the first D characters of a long one) pulled into the loser tree of SubstrSorter
+///
+/// Characters are kept in a fixed array, no allocation is done when a substr is deserialized.
+/// If D characters fit in seven bytes (e.g., D = 4 for 8-bit alphabets), a substr is also packed into a 64-bit key,
+/// so that two substrs are compared by a single integer comparison.
 template<typename alphabet_type, uint D>
 struct Substr{
 
@@ -17,11 +26,17 @@ private:
 
 	typedef typename ExVector<uint8>::vector uint8_vector_type;
 
+	static constexpr bool IS_PACKED = (sizeof(alphabet_type) * D < sizeof(uint64)); ///< pack into a 64-bit key
+
 public:
 
-	std::vector<alphabet_type> data; // store at most D characters
+	std::array<alphabet_type, D> data; // store at most D characters
+
+	uint8 len; // number of characters in data
 
 	bool is_short; // short or long
+
+	uint64 key; // packed characters followed by a tie-breaking byte, valid if IS_PACKED
 	
 public:
 
@@ -37,16 +52,18 @@ public:
 			return false;
 		}
 
-		uint8 len = static_cast<uint8>(*_substr_len_it); // len < UINT8_MAX 
+		len = static_cast<uint8>(*_substr_len_it); // len <= D 
 
-		++_substr_len_it;
+		assert(len <= D);
 
-		data.resize(len);
+		++_substr_len_it;
 
 		for (uint8 i = 0; i < len; ++i) { data[i] = *_substr_ch_it; ++_substr_ch_it; }
 
 		is_short = true;
 
+		if (IS_PACKED) pack();
+
 		return true;
 	}
 
@@ -54,11 +71,13 @@ public:
 	///
 	void deserializeLong(typename alphabet_vector_type::const_iterator & _substr_ch_it) {
 
-		data.resize(D);
+		len = D;
 
 		for (uint8 i = 0; i < D; ++i) { data[i] = *_substr_ch_it; ++_substr_ch_it; }	
 
 		is_short = false;
+
+		if (IS_PACKED) pack();
 	} 
 	
 	
@@ -66,18 +85,23 @@ public:
 	/// 
 	int cmp(const Substr &_b) const {
 
-		auto iter_a = data.begin(), iter_b = _b.data.begin();
+		if (IS_PACKED) {
+
+			if (key != _b.key) return key < _b.key ? -1 : +1;
 
-		for (; iter_a != data.end() && iter_b != _b.data.end(); ++iter_a, ++iter_b) {
+			return is_short ? 0 : -1; // equal keys have the same type, a is long, a < b (see below)
+		}
+
+		for (uint8 i = 0; i < len && i < _b.len; ++i) {
 
-			if (*iter_a < *iter_b) return -1;
+			if (data[i] < _b.data[i]) return -1;
 
-			if (*iter_a > *iter_b) return +1;
+			if (data[i] > _b.data[i]) return +1;
 		}
 
-		if (iter_a != data.end()) return -1; // b is a prefix of a, a < b
+		if (len > _b.len) return -1; // b is a prefix of a, a < b
 		
-		if (iter_b != _b.data.end()) return +1; // a is a prefix of b, a > b
+		if (len < _b.len) return +1; // a is a prefix of b, a > b
 
 		if (is_short == false) return -1; // a is long, then b is a prefix of a, a < b
 
@@ -90,21 +114,41 @@ public:
 	void swap(Substr<alphabet_type, D> & _b) {
 
 		std::swap(data, _b.data);
+
+		std::swap(len, _b.len);
 	
 		std::swap(is_short, _b.is_short);
+
+		std::swap(key, _b.key);
 	} 
 
 	void output() const{
 
-		auto it = data.begin();
-
-		for (; it != data.end(); ++it) {
+		for (uint8 i = 0; i < len; ++i) {
 
-			std::cerr << (uint32)*it << " ";
+			std::cerr << (uint32)data[i] << " ";
 		}
 
 		std::cerr << std::endl;
 	}
+
+private:
+
+	/// \brief pack the characters into key
+	///
+	/// Missing characters are padded by the largest character and the lowest byte breaks ties: D + 1 - len for a short substr, 0 for a long one.
+	/// Comparing the keys is equivalent to cmp, where a substr is smaller than its proper prefix and a long substr is smaller than a short one with the same characters.
+	void pack() {
+
+		key = 0;
+
+		for (uint8 i = 0; i < D; ++i) {
+
+			key = (key << (IS_PACKED ? 8 * sizeof(alphabet_type) : 0)) | static_cast<uint64>(i < len ? data[i] : std::numeric_limits<alphabet_type>::max());
+		}
+
+		key = (key << 8) | (is_short ? static_cast<uint64>(D + 1 - len) : 0);
+	}
 };
 
 
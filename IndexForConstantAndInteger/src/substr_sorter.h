@@ -5,8 +5,14 @@
 #include "substr.h"
 #include "losertree.h"
 
+#include <vector>
+#include <thread>
+#include <algorithm>
+
 #define TEST_DEBUG_SUBSTR_SORTER
 
+constexpr uint32 SPLITTER_SAMPLE_NUM = 32; ///< substrs sampled from a short seq for each thread when choosing the splitters
+
 template<typename alphabet_type, typename offset_type, uint8 D>
 class SubstrSorter{
 
@@ -20,6 +26,8 @@ private:
 
 	typedef typename ExVector<uint32>::vector uint32_vector_type;
 
+	typedef Pair<offset_type, offset_type> pair_type; ///< <position, name>
+
 public:
 
 	struct StrCompare{
@@ -98,6 +106,50 @@ public:
 	};
 
 
+	/// \brief a substr loaded into RAM for the parallel merge
+	///
+	struct Item{
+
+		Substr<alphabet_type, D> str;
+
+		offset_type pos; ///< starting position
+
+		bool diff_next; ///< for a long substr, it differs from the next long one
+	};
+
+	/// \brief compare the heads of the ranges merged in a partition
+	///
+	struct RangeCompare{
+
+	public:
+
+		const std::vector<std::vector<Item>> & m_bufs;
+
+		std::vector<size_t> m_cur; ///< current item of each range
+
+		std::vector<size_t> m_end; ///< end of each range
+
+	public:
+
+		/// \brief ctor
+		///
+		RangeCompare(const std::vector<std::vector<Item>> & _bufs, const std::vector<size_t> & _beg, const std::vector<size_t> & _end) : m_bufs(_bufs), m_cur(_beg), m_end(_end) {}
+
+		/// \brief check existence
+		///
+		bool exists(const uint8 _seq) const {
+
+			return m_cur[_seq] < m_end[_seq];
+		}
+
+		/// \brief compare
+		///
+		int operator()(const uint8 _seqa, const uint8 _seqb) const {
+
+			return m_bufs[_seqa][m_cur[_seqa]].str.cmp(m_bufs[_seqb][m_cur[_seqb]].str);
+		}
+	};
+
 	StrCompare m_cmp; ///< instance of comparator
 
 	LoserTree3Way<StrCompare> m_ltree; ///< instance of losertree
@@ -272,26 +324,14 @@ public:
 	}
 
 
-	/// \brief 
+	/// \brief merge the sorted S*-substrs by a loser tree and name them one by one
 	///
-	bool process(offset_vector_type*& _s1, const uint64 _s_size) {
+	template<typename sorter_type>
+	bool merge(sorter_type * _sorter_lms) {
 
 		bool is_unique = true;
-		//
-		typedef Pair<offset_type, offset_type> pair_type;
 
-		typedef TupleAscCmp1<pair_type> pair_comparator_type;
-
-		typedef typename ExSorter<pair_type, pair_comparator_type>::sorter sorter_type;
-	
-		sorter_type *sorter_lms = new sorter_type(pair_comparator_type(), MAX_MEM);
-
-		//
-		offset_type name = 0; // for the sentinel
-
-		sorter_lms->push(pair_type(_s_size - 1, name)); // push the sentinel
-
-		++name;
+		offset_type name = 1; // 0 for the sentinel
 
 		start(); // start comparing
 
@@ -299,7 +339,7 @@ public:
 
 		offset_type pos = get_cur_pos();
 
-		sorter_lms->push(pair_type(pos, name)); // push current loser
+		_sorter_lms->push(pair_type(pos, name)); // push current loser
 
 		forward();
 
@@ -339,13 +379,275 @@ public:
 
 			offset_type pos = get_cur_pos();
 
-			sorter_lms->push(pair_type(pos, name));
+			_sorter_lms->push(pair_type(pos, name));
 
 			pre_str.swap(cur_str);
 
 			forward();
 		}
 
+		return is_unique;
+	}
+
+	/// \brief merge the sorted S*-substrs in rounds, each round is partitioned by splitters and merged by _thread_num threads
+	///
+	/// A round loads a batch of substrs from each seq and takes those no greater than the smallest last loaded one of the seqs not exhausted,
+	/// the others are kept for the next round. The batches are partitioned by splitters sampled from the sorted run of each block,
+	/// equal substrs fall in the same partition. Each partition is merged and named from 0 by a thread,
+	/// the names are then offset by the prefix sum of the name counts of the preceding partitions.
+	template<typename sorter_type>
+	bool mergeParallel(sorter_type * _sorter_lms, const uint32 _thread_num) {
+
+		const size_t capacity = std::max(MAX_MEM / 4 / (sizeof(Item) + sizeof(pair_type)) / m_seq_num, uint64(1)); // items loaded for each seq
+
+		std::vector<std::vector<Item>> bufs(m_seq_num);
+
+		std::vector<bool> is_exhausted(m_seq_num, false);
+
+		std::vector<size_t> round_end(m_seq_num);
+
+		std::vector<std::vector<size_t>> bounds(_thread_num + 1, std::vector<size_t>(m_seq_num, 0)); // bounds of the partitions in each seq, bounds[0] is always 0
+
+		std::vector<std::vector<pair_type>> outputs(_thread_num);
+
+		std::vector<offset_type> name_nums(_thread_num);
+
+		std::vector<uint8> is_uniques(_thread_num);
+
+		std::vector<const Item*> firsts(_thread_num), lasts(_thread_num);
+
+		bool is_unique = true, has_last = false;
+
+		Item last; // last named substr
+
+		offset_type name = 0; // name of the last named substr, 0 for the sentinel
+
+		while (true) {
+
+			// load and find the bound of the round
+			int bound_seq = -1;
+
+			for (uint8 i = 0; i < m_seq_num; ++i) {
+
+				if (!is_exhausted[i]) is_exhausted[i] = load(i, bufs[i], capacity);
+
+				if (!is_exhausted[i] && (bound_seq == -1 || bufs[i].back().str.cmp(bufs[bound_seq].back().str) < 0)) bound_seq = i;
+			}
+
+			size_t round_num = 0;
+
+			for (uint8 i = 0; i < m_seq_num; ++i) {
+
+				round_end[i] = (bound_seq == -1 || i == bound_seq) ? bufs[i].size() : upperBound(bufs[i], 0, bufs[i].size(), bufs[bound_seq].back().str);
+
+				round_num += round_end[i];
+			}
+
+			if (round_num == 0) break;
+
+			// partition by splitters
+			std::vector<Substr<alphabet_type, D>> splitters;
+
+			selectSplitters(bufs, round_end, _thread_num, splitters);
+
+			for (uint8 i = 0; i < m_seq_num; ++i) {
+
+				for (uint32 j = 1; j < _thread_num; ++j) {
+
+					bounds[j][i] = (j - 1 < splitters.size()) ? upperBound(bufs[i], bounds[j - 1][i], round_end[i], splitters[j - 1]) : round_end[i];
+				}
+
+				bounds[_thread_num][i] = round_end[i];
+			}
+
+			// merge the partitions
+			std::vector<std::thread> threads;
+
+			for (uint32 j = 0; j < _thread_num; ++j) {
+
+				threads.push_back(std::thread(mergePartition, std::cref(bufs), std::cref(bounds[j]), std::cref(bounds[j + 1]), 
+								std::ref(outputs[j]), std::ref(name_nums[j]), std::ref(is_uniques[j]), std::ref(firsts[j]), std::ref(lasts[j])));
+			}
+
+			for (uint32 j = 0; j < _thread_num; ++j) threads[j].join();
+
+			// offset the names
+			for (uint32 j = 0; j < _thread_num; ++j) {
+
+				if (outputs[j].empty()) continue;
+
+				if (is_uniques[j] == false) is_unique = false;
+
+				const bool is_same = has_last && isEqual(last, *firsts[j]); // only possible for the first substr of a round
+
+				if (is_same) is_unique = false;
+
+				const uint64 base = static_cast<uint64>(name) + (is_same ? 0 : 1);
+
+				for (size_t k = 0; k < outputs[j].size(); ++k) {
+
+					_sorter_lms->push(pair_type(outputs[j][k].first, static_cast<offset_type>(base + static_cast<uint64>(outputs[j][k].second))));
+				}
+
+				name = static_cast<offset_type>(base + static_cast<uint64>(name_nums[j]) - 1);
+
+				last = *lasts[j], has_last = true;
+			}
+
+			for (uint8 i = 0; i < m_seq_num; ++i) {
+
+				bufs[i].erase(bufs[i].begin(), bufs[i].begin() + round_end[i]);
+			}
+		}
+
+		return is_unique;
+	}
+
+	/// \brief load substrs of a seq until _buf holds _capacity items
+	///
+	/// \return true if the seq is exhausted
+	bool load(const uint8 _seq, std::vector<Item> & _buf, const size_t _capacity) {
+
+		Item item;
+
+		while (_buf.size() < _capacity) {
+
+			if (_seq == m_seq_num - 1) { // long
+
+				if (m_long_aux_rit == m_long_aux_seq->rend()) return true;
+
+				uint8 aux = *m_long_aux_rit;
+
+				++m_long_aux_rit;
+
+				m_cmp.fetchLong(aux & 127);
+
+				item.diff_next = aux & 128;
+			}
+			else { // short
+
+				m_cmp.fetchShort(_seq);
+
+				if (!m_cmp.exists(_seq)) return true;
+
+				item.diff_next = true;
+			}
+
+			item.str = m_cmp.m_head[_seq];
+
+			m_cur_loser = _seq;
+
+			item.pos = get_cur_pos();
+
+			_buf.push_back(item);
+		}
+
+		return false;
+	}
+
+	/// \brief first item in _buf[_beg, _end) greater than _str
+	///
+	static size_t upperBound(const std::vector<Item> & _buf, const size_t _beg, const size_t _end, const Substr<alphabet_type, D> & _str) {
+
+		size_t beg = _beg, end = _end;
+
+		while (beg < end) {
+
+			const size_t mid = beg + (end - beg) / 2;
+
+			if (_buf[mid].str.cmp(_str) <= 0) beg = mid + 1; else end = mid;
+		}
+
+		return beg;
+	}
+
+	/// \brief sample the sorted run of short substrs of each block in a round and choose _thread_num - 1 splitters in ascending order
+	///
+	/// \note long substrs are not sampled, for two long ones with the same characters are not ordered by cmp
+	void selectSplitters(const std::vector<std::vector<Item>> & _bufs, const std::vector<size_t> & _round_end, const uint32 _thread_num, std::vector<Substr<alphabet_type, D>> & _splitters) const {
+
+		std::vector<Substr<alphabet_type, D>> samples;
+
+		for (uint8 i = 0; i < m_seq_num - 1; ++i) {
+
+			const size_t step = std::max(_round_end[i] / (SPLITTER_SAMPLE_NUM * _thread_num), size_t(1));
+
+			for (size_t k = step - 1; k < _round_end[i]; k += step) samples.push_back(_bufs[i][k].str);
+		}
+
+		if (samples.empty()) return;
+
+		std::sort(samples.begin(), samples.end(), [](const Substr<alphabet_type, D> & _a, const Substr<alphabet_type, D> & _b) { return _a.cmp(_b) < 0; });
+
+		for (uint32 j = 1; j < _thread_num; ++j) _splitters.push_back(samples[samples.size() * j / _thread_num]);
+	}
+
+	/// \brief two successive substrs in the merged order are equal
+	///
+	static bool isEqual(const Item & _a, const Item & _b) {
+
+		if (!_a.str.is_short && !_b.str.is_short) return !_a.diff_next; // two successive long ones
+
+		return _a.str.cmp(_b.str) == 0;
+	}
+
+	/// \brief merge the ranges [_beg, _end) of the seqs and name the substrs from 0
+	///
+	static void mergePartition(const std::vector<std::vector<Item>> & _bufs, const std::vector<size_t> & _beg, const std::vector<size_t> & _end,
+				std::vector<pair_type> & _output, offset_type & _name_num, uint8 & _is_unique, const Item* & _first, const Item* & _last) {
+
+		_output.clear(), _name_num = 0, _is_unique = true, _first = _last = nullptr;
+
+		RangeCompare cmp(_bufs, _beg, _end);
+
+		LoserTree3Way<RangeCompare> ltree(cmp);
+
+		ltree.play_initial(_bufs.size());
+
+		while (!ltree.done()) {
+
+			const uint8 seq = ltree.top();
+
+			const Item & cur = _bufs[seq][cmp.m_cur[seq]];
+
+			if (_last == nullptr) {
+
+				_first = &cur, ++_name_num;
+			}
+			else if (ltree.top_equal() || isEqual(*_last, cur)) {
+
+				_is_unique = false;
+			}
+			else {
+
+				++_name_num;
+			}
+
+			_output.push_back(pair_type(cur.pos, _name_num - 1));
+
+			_last = &cur;
+
+			++cmp.m_cur[seq];
+
+			ltree.replay();
+		}
+	}
+
+	/// \brief merge the sorted S*-substrs and name them, the names are output in s1 in the order of their positions
+	///
+	/// \note the merge is partitioned and run by _thread_num threads if _thread_num > 1
+	bool process(offset_vector_type*& _s1, const uint64 _s_size, const uint32 _thread_num = 1) {
+
+		typedef TupleAscCmp1<pair_type> pair_comparator_type;
+
+		typedef typename ExSorter<pair_type, pair_comparator_type>::sorter sorter_type;
+	
+		sorter_type *sorter_lms = new sorter_type(pair_comparator_type(), _thread_num > 1 ? MAX_MEM / 2 : MAX_MEM); // leave space for the batches of the parallel merge
+
+		sorter_lms->push(pair_type(_s_size - 1, 0)); // push the sentinel, named 0
+
+		bool is_unique = (_thread_num > 1) ? mergeParallel(sorter_lms, _thread_num) : merge(sorter_lms);
+
 		sorter_lms->sort();
 
 #ifdef TEST_DEBUG_SUBSTR_SORTER
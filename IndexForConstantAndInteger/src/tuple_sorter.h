@@ -2,9 +2,14 @@
 #define MY_TUPLE_SORTER_H
 
 #include "common.h"
+#include "io.h"
 	
 #include "stxxl/sorter"
 
+#include <vector>
+#include <thread>
+#include <algorithm>
+
 
 /// \brief sort tuples by 1st component in ascending order
 ///
@@ -152,4 +157,204 @@ struct TupleDscCmp3{
 };
 
 
+/// \brief stxxl sorter forming runs in several threads
+///
+/// Pushed tuples are buffered in batches, one batch for each underlying sorter.
+/// Once all the batches are full, they are pushed into the sorters by worker threads while the next ones are filled,
+/// so the runs are sorted concurrently with the producer. The sorted tuples are retrieved by merging the sorters.
+/// With a single thread, tuples are pushed into the only sorter directly.
+///
+template<typename tuple_type, typename comparator_type>
+class ParallelSorter{
+
+private:
+
+	typedef typename ExSorter<tuple_type, comparator_type>::sorter sorter_type;
+
+	const comparator_type m_cmp;
+
+	std::vector<sorter_type*> m_sorters;
+
+	std::vector<std::vector<tuple_type>> m_batches; ///< batches being filled
+
+	std::vector<std::vector<tuple_type>> m_pushed_batches; ///< batches being pushed by the worker threads
+
+	std::vector<std::thread> m_threads;
+
+	size_t m_batch_size; ///< max number of tuples in a batch
+
+	uint32 m_cur; ///< the batch being filled
+
+	uint32 m_min; ///< the sorter holding the smallest tuple, valid after sort()
+
+public:
+
+	/// \brief ctor
+	///
+	/// \note One eighth of _mem is reserved for the batches if using several threads.
+	///
+	ParallelSorter(const comparator_type & _cmp, const uint64 _mem, const uint32 _thread_num = 1) : m_cmp(_cmp), m_sorters(_thread_num), m_cur(0), m_min(0) {
+
+		uint64 sorter_mem = (_thread_num > 1) ? (_mem - _mem / 8) / _thread_num : _mem;
+
+		for (uint32 i = 0; i < _thread_num; ++i) m_sorters[i] = new sorter_type(_cmp, sorter_mem);
+
+		if (_thread_num > 1) {
+
+			m_batch_size = std::max<uint64>(_mem / 8 / (2 * _thread_num) / sizeof(tuple_type), 1);
+
+			m_batches.resize(_thread_num), m_pushed_batches.resize(_thread_num);
+
+			for (uint32 i = 0; i < _thread_num; ++i) m_batches[i].reserve(m_batch_size), m_pushed_batches[i].reserve(m_batch_size);
+		}
+	}
+
+	/// \brief dtor
+	///
+	~ParallelSorter() {
+
+		join();
+
+		for (uint32 i = 0; i < m_sorters.size(); ++i) {
+
+			delete m_sorters[i]; m_sorters[i] = nullptr;
+		}
+	}
+
+	/// \brief push a tuple
+	///
+	void push(const tuple_type & _tuple) {
+
+		if (m_sorters.size() == 1) {
+
+			m_sorters[0]->push(_tuple);
+
+			return;
+		}
+
+		m_batches[m_cur].push_back(_tuple);
+
+		if (m_batches[m_cur].size() == m_batch_size && ++m_cur == m_batches.size()) {
+
+			flush();
+
+			m_cur = 0;
+		}
+	}
+
+	/// \brief push the remaining tuples and sort the sorters concurrently
+	///
+	void sort() {
+
+		if (m_sorters.size() > 1) {
+
+			flush();
+
+			join();
+
+			for (uint32 i = 0; i < m_sorters.size(); ++i) {
+
+				m_threads.push_back(std::thread([](sorter_type * _sorter) { _sorter->sort(); }, m_sorters[i]));
+			}
+
+			join();
+		}
+		else {
+
+			m_sorters[0]->sort();
+		}
+
+		findMin();
+	}
+
+	/// \brief check if all the sorted tuples are retrieved
+	///
+	bool empty() const {
+
+		return m_sorters[m_min]->empty();
+	}
+
+	/// \brief number of tuples
+	///
+	uint64 size() const {
+
+		uint64 size = 0;
+
+		for (uint32 i = 0; i < m_sorters.size(); ++i) size += m_sorters[i]->size();
+
+		return size;
+	}
+
+	/// \brief the smallest tuple not retrieved
+	///
+	const tuple_type & operator*() const {
+
+		return *(*m_sorters[m_min]);
+	}
+
+	/// \brief the smallest tuple not retrieved
+	///
+	const tuple_type * operator->() const {
+
+		return &(*(*m_sorters[m_min]));
+	}
+
+	/// \brief retrieve the smallest tuple
+	///
+	ParallelSorter & operator++() {
+
+		++(*m_sorters[m_min]);
+
+		if (m_sorters.size() > 1) findMin();
+
+		return *this;
+	}
+
+private:
+
+	/// \brief wait for the worker threads
+	///
+	void join() {
+
+		for (uint32 i = 0; i < m_threads.size(); ++i) m_threads[i].join();
+
+		m_threads.clear();
+	}
+
+	/// \brief push the filled batches by the worker threads, the producer goes on with the swapped (empty) batches
+	///
+	void flush() {
+
+		join();
+
+		m_batches.swap(m_pushed_batches);
+
+		for (uint32 i = 0; i < m_sorters.size(); ++i) {
+
+			if (m_pushed_batches[i].empty()) continue;
+
+			m_threads.push_back(std::thread([](sorter_type * _sorter, std::vector<tuple_type> * _batch) {
+
+				for (size_t j = 0; j < _batch->size(); ++j) _sorter->push((*_batch)[j]);
+
+				_batch->clear();
+
+			}, m_sorters[i], &m_pushed_batches[i]));
+		}
+	}
+
+	/// \brief find the sorter holding the smallest tuple, the number of sorters is small
+	///
+	void findMin() {
+
+		for (uint32 i = 0; i < m_sorters.size(); ++i) {
+
+			if (m_sorters[i]->empty()) continue;
+
+			if (m_sorters[m_min]->empty() || m_cmp(*(*m_sorters[i]), *(*m_sorters[m_min]))) m_min = i;
+		}
+	}
+};
+
+
 #endif // MY_TUPLE_SORTER_H
@@ -0,0 +1,118 @@
+#!/bin/bash
+# Run the builders over synthetic corpora of increasing sizes and collect one CSV row per run.
+#
+# usage: bench.sh [-b bin_dir] [-w work_dir] [-o result_csv] [-s "sizes"] [-k "kinds"] [-r seed]
+#   -b  directory containing gen and measure (default: directory of this script)
+#   -w  directory for corpora and outputs, must have room for the largest run (default: ./bench_work)
+#   -o  result file (default: bench_results.csv), rows are appended
+#   -s  size ladder (default: "1M 4M 16M 64M")
+#   -k  corpus kinds (default: "uniform zipf repetitive dna runs tokens")
+#   -r  seed for the generator (default: 2017)
+#
+# Builders are given by environment variables, an unset builder is skipped:
+#   DSAIS1N   directory containing the build program of dsais1n
+#   DSAIS     directory containing the build program of IndexForConstantAndInteger
+#   SAISMM    path to the main program of saismm (writes corpus.sa)
+#   BININDEX  command building the binary index, the corpus path is appended as the last argument
+#
+# Columns: builder, kind, size (bytes), exit status, elapsed time (s), throughput (MB/s), user time (s),
+# system time (s), peak RSS (KB), read/write volume per char and peak disk use per char.
+# The last three columns come from --metrics and are NA for builders without it.
+
+bin_dir=$(cd "$(dirname "$0")" && pwd)
+work_dir=./bench_work
+result=bench_results.csv
+sizes="1M 4M 16M 64M"
+kinds="uniform zipf repetitive dna runs tokens"
+seed=2017
+
+while getopts "b:w:o:s:k:r:" opt; do
+	case $opt in
+		b) bin_dir=$OPTARG ;;
+		w) work_dir=$OPTARG ;;
+		o) result=$OPTARG ;;
+		s) sizes=$OPTARG ;;
+		k) kinds=$OPTARG ;;
+		r) seed=$OPTARG ;;
+		*) exit 1 ;;
+	esac
+done
+
+for tool in gen measure; do
+	if [ ! -x "$bin_dir/$tool" ]; then
+		echo "$bin_dir/$tool not found, build the benchmark first." >&2
+		exit 1
+	fi
+done
+
+mkdir -p "$work_dir"
+
+result=$(cd "$(dirname "$result")" && pwd)/$(basename "$result")
+
+if [ ! -s "$result" ]; then
+	echo "builder,kind,size,status,elapsed,throughput,user,system,peak_rss,read_per_char,write_per_char,pdu_per_char" > "$result"
+fi
+
+# extract a top-level field from a metrics document, NA if absent
+metric() {
+	local value
+	value=$(sed -n "s/^\t\"$2\": \([^,]*\),\{0,1\}$/\1/p" "$1" 2>/dev/null)
+	echo "${value:-NA}"
+}
+
+# run a builder on the corpus and append a row
+# usage: run builder kind size corpus command...
+run() {
+	local builder=$1 kind=$2 size=$3 corpus=$4
+	shift 4
+
+	rm -f metrics.json
+
+	# the builder shares stdout with measure, whose line is the last one
+	local stats
+	stats=$("$bin_dir/measure" "$@" 2>"$builder.log" | tail -n 1)
+
+	local status elapsed user system rss
+	read -r status elapsed user system rss <<< "$stats"
+
+	local throughput
+	throughput=$(awk -v n="$size" -v t="$elapsed" 'BEGIN { if (t > 0) printf "%.3f", n / 1048576 / t; else print "NA" }')
+
+	echo "$builder,$kind,$size,$status,$elapsed,$throughput,$user,$system,$rss,$(metric metrics.json read_volume_per_char),$(metric metrics.json write_volume_per_char),$(metric metrics.json peak_disk_use_per_char)" >> "$result"
+
+	echo "$builder $kind $size: status $status, $elapsed s, $throughput MB/s, peak RSS $rss KB"
+
+	rm -f "$corpus.sa" "$corpus.sa.tmp" metrics.json
+}
+
+cd "$work_dir" || exit 1
+
+for kind in $kinds; do
+	for size in $sizes; do
+		corpus=$kind.$size
+
+		"$bin_dir/gen" "$kind" "$size" "$seed" "$corpus" || exit 1
+
+		bytes=$(stat -c %s "$corpus")
+
+		if [ -n "$DSAIS1N" ]; then
+			run dsais1n "$kind" "$bytes" "$corpus" "$DSAIS1N/build" "$corpus" "$corpus.sa" --metrics metrics.json
+			rm -f tmp_dsais1n_*
+		fi
+
+		if [ -n "$DSAIS" ]; then
+			run dsais "$kind" "$bytes" "$corpus" "$DSAIS/build" "$corpus" "$corpus.sa" --metrics metrics.json
+		fi
+
+		if [ -n "$SAISMM" ]; then
+			run saismm "$kind" "$bytes" "$corpus" "$SAISMM" "$corpus"
+		fi
+
+		if [ -n "$BININDEX" ]; then
+			# word splitting of BININDEX is intended, it may carry arguments
+			run binindex "$kind" "$bytes" "$corpus" $BININDEX "$corpus"
+		fi
+
+		rm -f "$corpus"
+	done
+done
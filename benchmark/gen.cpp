@@ -0,0 +1,330 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file gen.cpp
+/// \brief Generate synthetic corpora for benchmarking the builders.
+///
+/// Usage: gen kind size seed output_path [sigma]
+/// kind: uniform | zipf | repetitive | dna | runs | tokens
+/// size: number of bytes, suffixes K, M and G are allowed (e.g., 64M)
+/// sigma: alphabet size for uniform, zipf, repetitive and runs (default: 254)
+///
+/// Corpora are reproducible: the same arguments produce the same bytes on any platform,
+/// because the generator and the sampling procedures are implemented here instead of using <random>.
+/// Characters lie in [1, 254], so the corpora need no formatting before running the builders.
+///////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+typedef uint8_t uint8;
+
+typedef uint32_t uint32;
+
+typedef uint64_t uint64;
+
+constexpr uint32 SIGMA_MAX = 254; ///< characters are in [1, SIGMA_MAX]
+
+constexpr uint64 BUF_SIZE = 1024 * 1024; ///< output buffer size
+
+/// \brief splitmix64, a small and portable pseudo-random generator
+///
+class Random{
+
+private:
+
+	uint64 m_state;
+
+public:
+
+	/// \brief ctor
+	///
+	Random(const uint64 _seed) : m_state(_seed) {}
+
+	/// \brief next 64 random bits
+	///
+	uint64 next() {
+
+		uint64 z = (m_state += 0x9E3779B97F4A7C15ULL);
+
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+		return z ^ (z >> 31);
+	}
+
+	/// \brief uniform integer in [0, _n)
+	///
+	uint64 uniform(const uint64 _n) {
+
+		return static_cast<uint64>((static_cast<unsigned __int128>(next()) * _n) >> 64);
+	}
+
+	/// \brief uniform real in [0, 1)
+	///
+	double real() {
+
+		return (next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+};
+
+/// \brief sample ranks in [0, _n) with probability proportional to 1 / (rank + 1)^_s
+///
+class ZipfSampler{
+
+private:
+
+	std::vector<double> m_cdf;
+
+public:
+
+	/// \brief ctor
+	///
+	ZipfSampler(const uint64 _n, const double _s) : m_cdf(_n) {
+
+		double sum = 0;
+
+		for (uint64 i = 0; i < _n; ++i) sum += 1.0 / std::pow(static_cast<double>(i + 1), _s), m_cdf[i] = sum;
+
+		for (uint64 i = 0; i < _n; ++i) m_cdf[i] /= sum;
+	}
+
+	/// \brief sample a rank
+	///
+	uint64 sample(Random & _rand) const {
+
+		const uint64 rank = std::upper_bound(m_cdf.begin(), m_cdf.end(), _rand.real()) - m_cdf.begin();
+
+		return std::min(rank, static_cast<uint64>(m_cdf.size() - 1));
+	}
+};
+
+/// \brief buffered writer for the output corpus
+///
+class CorpusWriter{
+
+private:
+
+	FILE *m_file;
+
+	std::vector<uint8> m_buf;
+
+	uint64 m_written;
+
+	const uint64 m_size;
+
+public:
+
+	/// \brief ctor
+	///
+	CorpusWriter(const std::string & _fname, const uint64 _size) : m_written(0), m_size(_size) {
+
+		m_file = fopen(_fname.c_str(), "wb");
+
+		if (m_file == nullptr) {
+
+			std::cerr << "fail to create " << _fname << "\n";
+
+			exit(-1);
+		}
+
+		m_buf.reserve(BUF_SIZE);
+	}
+
+	/// \brief dtor
+	///
+	~CorpusWriter() {
+
+		flush();
+
+		fclose(m_file);
+	}
+
+	/// \brief check if the corpus reaches the required size
+	///
+	bool full() const {
+
+		return m_written == m_size;
+	}
+
+	/// \brief append a character, ignored if full
+	///
+	void put(const uint8 _ch) {
+
+		if (full()) return;
+
+		m_buf.push_back(_ch), ++m_written;
+
+		if (m_buf.size() == BUF_SIZE) flush();
+	}
+
+private:
+
+	/// \brief write the buffer
+	///
+	void flush() {
+
+		fwrite(m_buf.data(), 1, m_buf.size(), m_file);
+
+		m_buf.clear();
+	}
+};
+
+/// \brief i.i.d. characters drawn uniformly
+///
+void genUniform(CorpusWriter & _writer, Random & _rand, const uint32 _sigma) {
+
+	while (!_writer.full()) _writer.put(1 + _rand.uniform(_sigma));
+}
+
+/// \brief i.i.d. characters drawn by Zipf's law (s = 1)
+///
+void genZipf(CorpusWriter & _writer, Random & _rand, const uint32 _sigma) {
+
+	ZipfSampler zipf(_sigma, 1.0);
+
+	while (!_writer.full()) _writer.put(1 + zipf.sample(_rand));
+}
+
+/// \brief copies of a random base sequence, each character mutated with probability 0.001
+///
+void genRepetitive(CorpusWriter & _writer, Random & _rand, const uint32 _sigma, const uint64 _size) {
+
+	const uint64 base_len = std::max(static_cast<uint64>(64), std::min(static_cast<uint64>(1024 * 1024), _size / 100));
+
+	std::vector<uint8> base(base_len);
+
+	for (uint64 i = 0; i < base_len; ++i) base[i] = 1 + _rand.uniform(_sigma);
+
+	while (!_writer.full()) {
+
+		for (uint64 i = 0; i < base_len; ++i) _writer.put((_rand.uniform(1000) == 0) ? 1 + _rand.uniform(_sigma) : base[i]);
+	}
+}
+
+/// \brief i.i.d. nucleotides
+///
+void genDNA(CorpusWriter & _writer, Random & _rand) {
+
+	const uint8 nucleotides[4] = {'A', 'C', 'G', 'T'};
+
+	while (!_writer.full()) _writer.put(nucleotides[_rand.uniform(4)]);
+}
+
+/// \brief runs of random characters, run lengths are geometric with mean 32
+///
+void genRuns(CorpusWriter & _writer, Random & _rand, const uint32 _sigma) {
+
+	while (!_writer.full()) {
+
+		const uint8 ch = 1 + _rand.uniform(_sigma);
+
+		do {
+
+			_writer.put(ch);
+
+		} while (!_writer.full() && _rand.uniform(32) != 0);
+	}
+}
+
+/// \brief words drawn by Zipf's law from a random vocabulary of 65536 words, separated by spaces
+///
+void genTokens(CorpusWriter & _writer, Random & _rand) {
+
+	const uint32 vocabulary_size = 65536;
+
+	std::vector<std::string> vocabulary(vocabulary_size);
+
+	for (uint32 i = 0; i < vocabulary_size; ++i) {
+
+		const uint32 len = 2 + _rand.uniform(9);
+
+		for (uint32 j = 0; j < len; ++j) vocabulary[i] += static_cast<char>('a' + _rand.uniform(26));
+	}
+
+	ZipfSampler zipf(vocabulary_size, 1.0);
+
+	while (!_writer.full()) {
+
+		const std::string & word = vocabulary[zipf.sample(_rand)];
+
+		for (size_t j = 0; j < word.size(); ++j) _writer.put(word[j]);
+
+		_writer.put(' ');
+	}
+}
+
+/// \brief parse a size with an optional suffix K, M or G
+///
+uint64 parseSize(const std::string & _str) {
+
+	uint64 size = std::stoull(_str);
+
+	switch (_str.back()) {
+
+	case 'K': case 'k': size <<= 10; break;
+
+	case 'M': case 'm': size <<= 20; break;
+
+	case 'G': case 'g': size <<= 30; break;
+
+	default: break;
+	}
+
+	return size;
+}
+
+int main(int argc, char** argv) {
+
+	if (argc < 5) {
+
+		std::cerr << "four param required: kind size seed output_path.\n";
+
+		std::cerr << "kind: uniform | zipf | repetitive | dna | runs | tokens.\n";
+
+		std::cerr << "optional param: sigma (alphabet size for uniform, zipf, repetitive and runs, at most 254, default: 254).\n";
+
+		exit(-1);
+	}
+
+	const std::string kind(argv[1]);
+
+	const uint64 size = parseSize(argv[2]);
+
+	Random rand(std::stoull(argv[3]));
+
+	const std::string fname(argv[4]);
+
+	const uint32 sigma = (argc > 5) ? std::stoul(argv[5]) : SIGMA_MAX;
+
+	if (sigma == 0 || sigma > SIGMA_MAX) {
+
+		std::cerr << "sigma must be in [1, " << SIGMA_MAX << "].\n";
+
+		exit(-1);
+	}
+
+	CorpusWriter writer(fname, size);
+
+	if (kind == "uniform") genUniform(writer, rand, sigma);
+	else if (kind == "zipf") genZipf(writer, rand, sigma);
+	else if (kind == "repetitive") genRepetitive(writer, rand, sigma, size);
+	else if (kind == "dna") genDNA(writer, rand);
+	else if (kind == "runs") genRuns(writer, rand, sigma);
+	else if (kind == "tokens") genTokens(writer, rand);
+	else {
+
+		std::cerr << "unknown kind: " << kind << "\n";
+
+		exit(-1);
+	}
+
+	return 0;
+}
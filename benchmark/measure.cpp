@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file measure.cpp
+/// \brief Run a command and report its elapsed time, CPU time and peak memory.
+///
+/// Usage: measure command [args...]
+/// On exit of the command, one line is printed to stdout:
+/// exit_status elapsed_time(s) user_time(s) system_time(s) peak_rss(KB)
+/// The output of the command is left untouched. The exit status of measure is that of the command.
+///////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <iostream>
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+
+	if (argc < 2) {
+
+		std::cerr << "one param required: command.\n";
+
+		exit(-1);
+	}
+
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+	pid_t pid = fork();
+
+	if (pid == -1) {
+
+		std::cerr << "fail to fork.\n";
+
+		exit(-1);
+	}
+
+	if (pid == 0) {
+
+		execvp(argv[1], argv + 1);
+
+		std::cerr << "fail to execute " << argv[1] << "\n";
+
+		_exit(127);
+	}
+
+	int status = 0;
+
+	struct rusage usage;
+
+	if (wait4(pid, &status, 0, &usage) == -1) {
+
+		std::cerr << "fail to wait for " << argv[1] << "\n";
+
+		exit(-1);
+	}
+
+	const double elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+	const int exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+	printf("%d %.6f %.6f %.6f %ld\n", exit_status, elapsed_time, usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6,
+		usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6, usage.ru_maxrss);
+
+	return exit_status;
+}
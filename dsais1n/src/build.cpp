@@ -2,22 +2,77 @@
 
 #include "common.h"
 #include "builder.h"
+#include "disks.h"
 
 #include <iostream>
 #include <chrono>
 #include <fstream>
+#include <limits>
 
 
-int main(int argc, char** argv){
+/// \brief smallest offset width (in bytes) able to index the input string
+///
+/// \note Positions, ranks and names computed in the induction require _s_size + 3 distinct values.
+///
+uint8 fitOffsetWidth(const uint64 _s_size) {
+
+	if (_s_size + 3 <= std::numeric_limits<uint32>::max()) return sizeof(uint32);
+
+	if (_s_size + 3 <= static_cast<uint64>(std::numeric_limits<uint40>::max())) return sizeof(uint40);
+
+	return sizeof(uint64);
+}
+
+/// \brief compute the SA using offset_type and output it using sa_offset_type
+///
+template<typename alphabet_type, typename offset_type, typename sa_offset_type>
+void build(const std::string & _s_fname, const OutputInfo & _output_info) {
+
+	DSAIS<alphabet_type, offset_type, sa_offset_type> dsa(_s_fname, _output_info);
+
+	dsa.run();
+}
+
+/// \brief dispatch on the width of the output SA
+///
+template<typename alphabet_type, typename offset_type>
+void build(const uint8 _sa_width, const std::string & _s_fname, const OutputInfo & _output_info) {
+
+	switch (_sa_width) {
+
+	case sizeof(uint32): build<alphabet_type, offset_type, uint32>(_s_fname, _output_info); break;
+
+	case sizeof(uint40): build<alphabet_type, offset_type, uint40>(_s_fname, _output_info); break;
 
-	// mount stxxl disk	
-	stxxl::config *cfg = stxxl::config::get_instance();
+	default: build<alphabet_type, offset_type, uint64>(_s_fname, _output_info); break;
+	}
+}
+
+/// \brief dispatch on the width of offsets used for computation
+///
+template<typename alphabet_type>
+void build(const uint8 _offset_width, const uint8 _sa_width, const std::string & _s_fname, const OutputInfo & _output_info) {
+
+	switch (_offset_width) {
+
+	case sizeof(uint32): build<alphabet_type, uint32>(_sa_width, _s_fname, _output_info); break;
+
+	case sizeof(uint40): build<alphabet_type, uint40>(_sa_width, _s_fname, _output_info); break;
+
+	default: build<alphabet_type, uint64>(_sa_width, _s_fname, _output_info); break;
+	}
+}
 
-	stxxl::disk_config disk("stxxl.tmp", 1024 * 1024 * 1024, "syscall autogrow unlink");
 
-	disk.direct = stxxl::disk_config::DIRECT_ON;
+int main(int argc, char** argv){
+
+	// mount stxxl disks, retrieved ahead of the other params
+	mountDisks(argc, argv);
 
-	cfg->add_disk(disk);
+	// statistics collection for the disk report
+	stxxl::stats_data disk_stats_begin(*stxxl::stats::get_instance());
+
+	const file_stats_list_type file_stats_begin = getFileStats(); // for the per-disk volumes
 	
 //	// statistics collection
 //	stxxl::stats *Stats = stxxl::stats::get_instance();
@@ -27,10 +82,36 @@ int main(int argc, char** argv){
 //	stxxl::block_manager *bm = stxxl::block_manager::get_instance();
 
 	// check if input params are legal
-	if (argc != 3) {
+	if (argc < 3) {
 
 		std::cerr << "two param required: input_path and output_path.\n";
 
+		std::cerr << "optional param: --sa-width 4|5|8 (bytes per SA entry, default: the smallest one fitting the input).\n";
+
+		std::cerr << "optional param: --alphabet-width 1|2|4 (bytes per character, default: 1).\n";
+
+		std::cerr << "optional param: --lcp lcp_path (output the LCP array using the SA width).\n";
+
+		std::cerr << "optional param: --bwt bwt_path (output the BWT, the sentinel is represented by 0).\n";
+
+		std::cerr << "optional param: --no-sa (do not output the SA).\n";
+
+		std::cerr << "optional param: --ssa ssa_path (output the sampled SA, with a bit vector ssa_path.bv marking sampled ranks if sampling by text).\n";
+
+		std::cerr << "optional param: --isa isa_path (output ISA samples at text positions 0, rate, 2 * rate, ...).\n";
+
+		std::cerr << "optional param: --sample-rate rate (default: 32), --sample-by text|rank (default: text).\n";
+
+		std::cerr << DISK_USAGE;
+
+		std::cerr << "optional param: --metrics metrics_path (output measurements in JSON, or in CSV if metrics_path ends with .csv).\n";
+
+		std::cerr << "optional param: --perf-counters (record hardware performance counters for each phase, if allowed by the kernel).\n";
+
+		std::cerr << "optional param: --checkpoint (keep intermediate results between phases for resuming an interrupted build).\n";
+
+		std::cerr << "optional param: --resume (resume an interrupted build from its checkpoints in the working directory, implies --checkpoint).\n";
+
 		exit(-1);
 	}	
 
@@ -39,7 +120,134 @@ int main(int argc, char** argv){
 	
 	// retrieve file name for output SA
 	std::string sa_fname(argv[2]);
+
+	OutputInfo output_info;
+
+	output_info.m_sa_fname = sa_fname;
+
+	// retrieve optional params
+	uint8 sa_width = 0;
+
+	uint8 alphabet_width = sizeof(uint8);
+
+	std::string metrics_fname;
+
+	for (int i = 3; i < argc; ++i) {
+
+		std::string param(argv[i]);
+
+		if (param == "--sa-width" && i + 1 < argc) {
+
+			const uint64 width = parseUInt(param, argv[++i]);
+
+			if (width != sizeof(uint32) && width != sizeof(uint40) && width != sizeof(uint64)) {
+
+				std::cerr << "sa width must be 4, 5 or 8.\n";
+
+				exit(-1);
+			}
+
+			sa_width = width;
+		}
+		else if (param == "--alphabet-width" && i + 1 < argc) {
+
+			const uint64 width = parseUInt(param, argv[++i]);
+
+			if (width != sizeof(uint8) && width != sizeof(uint16) && width != sizeof(uint32)) {
+
+				std::cerr << "alphabet width must be 1, 2 or 4.\n";
+
+				exit(-1);
+			}
+
+			alphabet_width = width;
+		}
+		else if (param == "--lcp" && i + 1 < argc) {
+
+			output_info.m_lcp_fname = argv[++i];
+		}
+		else if (param == "--bwt" && i + 1 < argc) {
+
+			output_info.m_bwt_fname = argv[++i];
+		}
+		else if (param == "--no-sa") {
+
+			output_info.m_sa_fname.clear();
+		}
+		else if (param == "--ssa" && i + 1 < argc) {
+
+			output_info.m_ssa_fname = argv[++i];
+		}
+		else if (param == "--isa" && i + 1 < argc) {
+
+			output_info.m_isa_fname = argv[++i];
+		}
+		else if (param == "--sample-rate" && i + 1 < argc) {
+
+			output_info.m_sample_rate = std::stoull(argv[++i]);
+
+			if (output_info.m_sample_rate == 0) {
+
+				std::cerr << "sample rate must be positive.\n";
+
+				exit(-1);
+			}
+		}
+		else if (param == "--metrics" && i + 1 < argc) {
+
+			metrics_fname = argv[++i];
+		}
+		else if (param == "--disk" && i + 1 < argc) {
+
+			++i; // mounted already
+		}
+		else if (param == "--perf-counters") {
+
+			Logger::enablePerfCounters();
+		}
+		else if (param == "--checkpoint") {
+
+			if (!Checkpoint::is_resuming()) Checkpoint::enable(false);
+		}
+		else if (param == "--resume") {
+
+			Checkpoint::enable(true);
+		}
+		else if (param == "--sample-by" && i + 1 < argc) {
+
+			std::string mode(argv[++i]);
+
+			if (mode == "text") {
+
+				output_info.m_sample_mode = SAMPLE_BY_TEXT;
+			}
+			else if (mode == "rank") {
+
+				output_info.m_sample_mode = SAMPLE_BY_RANK;
+			}
+			else {
+
+				std::cerr << "sample mode must be text or rank.\n";
+
+				exit(-1);
+			}
+		}
+		else {
+
+			std::cerr << "unknown param: " << param << "\n";
+
+			exit(-1);
+		}
+	}
 	
+	if (output_info.m_sa_fname.empty() && output_info.m_lcp_fname.empty() && output_info.m_bwt_fname.empty() && 
+		output_info.m_ssa_fname.empty() && output_info.m_isa_fname.empty()) {
+
+		std::cerr << "no output is required.\n";
+
+		exit(-1);
+	}
+
 	// compute input string's size
 	std::fstream s_stream(s_fname, std::fstream::in);
 
@@ -47,13 +255,70 @@ int main(int argc, char** argv){
 
 	uint64 s_size = s_stream.tellg();
 
+	if (s_size % alphabet_width != 0) {
+
+		std::cerr << "s size is not a multiple of the alphabet width.\n";
+
+		exit(-1);
+	}
+
+	s_size /= alphabet_width; // number of characters
+
+	// choose the smallest offset type for computation, the output SA must not be narrower
+	uint8 offset_width = fitOffsetWidth(s_size);
+
+	if (sa_width == 0) sa_width = offset_width;
+
+	if (sa_width < offset_width) {
+
+		std::cerr << "sa width " << (uint32)sa_width << " is too narrow for the input, at least " << (uint32)offset_width << " required.\n";
+
+		exit(-1);
+	}
+
 	// report static information
-	std::cerr << "s fname: " << s_fname << "\nsa fname: " << sa_fname << "\ns size: " << s_size / 1024 / 1024 << " MB" << std::endl;
+	std::cerr << "s fname: " << s_fname << "\nsa fname: " << output_info.m_sa_fname << "\ns size: " << s_size * alphabet_width / 1024 / 1024 << " MB" << std::endl;
+
+	std::cerr << "alphabet width: " << (uint32)alphabet_width << "\noffset width: " << (uint32)offset_width << "\nsa width: " << (uint32)sa_width << std::endl;
 
 	// compute the SA for the given string
-	DSAIS<uint8, uint40> dsa(s_fname, sa_fname);	
+	switch (alphabet_width) {
 
-	dsa.run();
+	case sizeof(uint8): build<uint8>(offset_width, sa_width, s_fname, output_info); break;
+
+	case sizeof(uint16): build<uint16>(offset_width, sa_width, s_fname, output_info); break;
+
+	default: build<uint32>(offset_width, sa_width, s_fname, output_info); break;
+	}
+
+	// output report
+	reportDisks(disk_stats_begin, file_stats_begin);
+
+	// output measurements
+	if (!metrics_fname.empty()) {
+
+		Metrics metrics;
+
+		metrics.addString("program", "build");
+
+		metrics.addString("input", s_fname);
+
+		metrics.addInteger("input_size", s_size);
+
+		metrics.addInteger("alphabet_width", alphabet_width);
+
+		metrics.addInteger("offset_width", offset_width);
+
+		metrics.addInteger("sa_width", sa_width);
+
+		metrics.addInteger("max_mem", MAX_MEM);
+
+		Logger::fillMetrics(metrics, s_size);
+
+		addDiskMetrics(metrics, file_stats_begin);
+
+		metrics.write(metrics_fname);
+	}
 
 //	// output report
 //	std::cerr << (stxxl::stats_data(*Stats) - stats_begin);
@@ -10,6 +10,8 @@
 #include "sorter.h"
 #include "pq_sub.h"
 #include "pq_suf.h"
+#include "sink.h"
+#include "checkpoint.h"
 
 #include <string>
 #include <fstream>
@@ -30,14 +32,12 @@ class DSAComputation;
 
 /// \brief preprocess 
 ///
-template<typename alphabet_type, typename offset_type>
+/// \note offset_type is used for computation, sa_offset_type for the output SA (not narrower than offset_type)
+///
+template<typename alphabet_type, typename offset_type, typename sa_offset_type = offset_type>
 class DSAIS{
 
 private:
-	typedef typename ExVector<alphabet_type>::vector alphabet_vector_type;
-
-	typedef typename ExVector<offset_type>::vector offset_vector_type;
-
 	typedef MyVector<alphabet_type> my_alphabet_vector_type;
 
 	typedef MyVector<offset_type> my_offset_vector_type;
@@ -46,41 +46,28 @@ private:
 
 	const std::string m_s_fname; ///< fname for input string
 
-	const std::string m_sa_fname; ///< fname for suffix array
+	const OutputInfo m_output_info; ///< fnames for output
 
 public:
 
 	/// \brief ctor
 	///
-	DSAIS(const std::string & _s_fname, const std::string & _sa_fname) : m_s_fname(_s_fname), m_sa_fname(_sa_fname) {}
+	DSAIS(const std::string & _s_fname, const OutputInfo & _output_info) : m_s_fname(_s_fname), m_output_info(_output_info) {}
 
 	/// \brief run
 	///
 	void run() {
 
-		// append a sentinel
-		stxxl::syscall_file *s_file = new stxxl::syscall_file(m_s_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
-
-		alphabet_vector_type *s_origin = new alphabet_vector_type(s_file);
-
-		typename alphabet_vector_type::bufreader_type s_origin_reader(*s_origin);
+		// number temporary files after those kept by checkpoints, if resuming
+		Checkpoint::prepare(m_s_fname);
 
-		my_alphabet_vector_type *s_target = new my_alphabet_vector_type();
+		// append a sentinel, the input string is read directly from the file
+		my_alphabet_vector_type *s_target = new my_alphabet_vector_type(m_s_fname);
 
-		uint64 s_origin_len = s_origin->size();
-
-		for (; !s_origin_reader.empty(); ++s_origin_reader) {
-
-			s_target->push_back(*s_origin_reader);
-		}
+		uint64 s_origin_len = s_target->size();
 
 		s_target->push_back(alphabet_type(0));
 
-#ifdef STATISTICS_COLLECTION
-
-		Logger::addIV(s_origin_len * sizeof(alphabet_type)); // read from s_origin (stxxl)
-#endif
-
 #ifdef DEBUG_TEST3
 
 		std::cerr << "target s:";
@@ -97,55 +84,29 @@ public:
 		std::cerr << "\n";
 #endif
 
-
-		// clear
-		delete s_origin; s_origin = nullptr;
-
-		delete s_file; s_file = nullptr;
-
-		// compute sa_reverse
+		// compute SA, the final suffixes are redirected to the sink for producing the outputs
 		my_offset_vector_type *sa_reverse = nullptr;
 
-		DSAComputation<alphabet_type, offset_type> dsac(s_target, 0, sa_reverse);
+		DSAISSink<alphabet_type, offset_type, sa_offset_type> sink(m_s_fname, m_output_info, s_origin_len);
+
+		DSAComputation<alphabet_type, offset_type> dsac(s_target, 0, sa_reverse, &sink);
 
 		dsac.run();
 
+		Checkpoint::finish();
+
 		// clear
 		delete s_target; s_target = nullptr;
 
-		// produce sa from sa_reverse (notice: pdu remains unchanged)
-		stxxl::syscall_file *sa_file = new stxxl::syscall_file(m_sa_fname, stxxl::syscall_file::CREAT | stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
-
-		offset_vector_type *sa = new offset_vector_type(sa_file); 
-
-		sa->resize(s_origin_len);
-
-		typename offset_vector_type::bufwriter_type sa_writer(*sa);
-
-		sa_reverse->start_read_reverse(); // start read reversely
-
-		sa_reverse->next_remove_reverse(); // skip the sentinel
-
-		while (!sa_reverse->is_eof()) {
-
-			sa_writer << sa_reverse->get_reverse();
-
-			sa_reverse->next_remove_reverse();
-		}
-
-		sa_writer.finish();
-
+		// write the outputs, compute LCP if required
+		{
 #ifdef STATISTICS_COLLECTION
 
-		Logger::addOV(s_origin_len * sizeof(offset_type)); // pdu remains unchanged but OV keep increasing for generating sa (stxxl)
+			LoggerPhase phase("output", 0);
 #endif
 
-		// clear
-		delete sa; sa = nullptr;
-
-		delete sa_file; sa_file = nullptr;
-
-		delete sa_reverse; sa_reverse = nullptr;
+			sink.finish();
+		}
 
 #ifdef STATISTICS_COLLECTION
 
@@ -201,7 +162,7 @@ private:
 		///
 		BlockInfo(const uint64 & _end_pos, const uint8 _id) : m_end_pos(_end_pos), m_id(_id) {
 
-			if (sizeof(alphabet_type) <= sizeof(uint32)) {
+			if (sizeof(alphabet_type) < sizeof(uint32)) { // no need to format input
 
 				double div = sizeof(alphabet_type) + double(1 / 8) + sizeof(uint32) + sizeof(uint32);
 
@@ -319,6 +280,8 @@ private:
 
 	offset_vector_type *& m_sa_reverse;
 
+	SuffixSink<alphabet_type, offset_type> *m_sink; ///< receive the final suffixes in descending order instead of m_sa_reverse, only for the top level (nullptr if not required)
+
 	std::vector<alphabet_vector_type*> m_sub_l_bwt_seqs;
 
 	std::vector<alphabet_vector_type*> m_sub_s_bwt_seqs;
@@ -333,7 +296,7 @@ private:
 
 public:
 
-	DSAComputation(alphabet_vector_type *& _s, const uint32 _level, offset_vector_type *& _sa_reverse);
+	DSAComputation(alphabet_vector_type *& _s, const uint32 _level, offset_vector_type *& _sa_reverse, SuffixSink<alphabet_type, offset_type> *_sink = nullptr);
 
 	void run();		 
 
@@ -369,12 +332,16 @@ public:
 	void sortSuffixMultiBlock(const BlockInfo & _block_info);
 
 	void mergeSortedSuffixGlobal();
+
+	void saveCheckpoint(const uint8 _stage, const bool _is_unique, offset_vector_type * _vec);
+
+	uint8 restoreCheckpoint(bool & _is_unique, offset_vector_type *& _sa1_reverse);
 };
 
 /// \brief ctor
 ///
 template<typename alphabet_type, typename offset_type>
-DSAComputation<alphabet_type, offset_type>::DSAComputation(alphabet_vector_type *& _s, const uint32 _level, offset_vector_type *& _sa_reverse) : ALPHA_MAX(std::numeric_limits<alphabet_type>::max()), ALPHA_MIN(std::numeric_limits<alphabet_type>::min()), OFFSET_MAX(std::numeric_limits<offset_type>::max()), OFFSET_MIN(std::numeric_limits<offset_type>::min()), m_s(_s), m_s_len(m_s->size()), m_level(_level), m_sa_reverse(_sa_reverse){}
+DSAComputation<alphabet_type, offset_type>::DSAComputation(alphabet_vector_type *& _s, const uint32 _level, offset_vector_type *& _sa_reverse, SuffixSink<alphabet_type, offset_type> *_sink) : ALPHA_MAX(std::numeric_limits<alphabet_type>::max()), ALPHA_MIN(std::numeric_limits<alphabet_type>::min()), OFFSET_MAX(std::numeric_limits<offset_type>::max()), OFFSET_MIN(std::numeric_limits<offset_type>::min()), m_s(_s), m_s_len(m_s->size()), m_level(_level), m_sa_reverse(_sa_reverse), m_sink(_sink){}
 
 /// \brief run
 ///
@@ -382,8 +349,20 @@ DSAComputation<alphabet_type, offset_type>::DSAComputation(alphabet_vector_type
 template<typename alphabet_type, typename offset_type>
 void DSAComputation<alphabet_type, offset_type>::run() {
 
-	// sort S*-substrs
-	bool is_unique = sortSStarGlobal();
+	bool is_unique = true;
+
+	offset_vector_type *sa1_reverse = nullptr;
+
+	// reuse the checkpoint of a previous run, if any
+	const uint8 stage = Checkpoint::is_resuming() ? restoreCheckpoint(is_unique, sa1_reverse) : static_cast<uint8>(CHECKPOINT_NONE);
+
+	if (stage == CHECKPOINT_NONE) {
+
+		// sort S*-substrs
+		is_unique = sortSStarGlobal();
+
+		if (Checkpoint::is_enabled()) saveCheckpoint(CHECKPOINT_REDUCED, is_unique, m_s1);
+	}
 
 #ifdef DEBUG_TEST3
 
@@ -399,8 +378,6 @@ void DSAComputation<alphabet_type, offset_type>::run() {
 	}
 #endif
 
-	offset_vector_type *sa1_reverse = nullptr;
-
 #ifdef DEBUG_TEST4
 
 	std::cerr << "level: " << m_level << std::endl; 
@@ -409,7 +386,12 @@ void DSAComputation<alphabet_type, offset_type>::run() {
 #endif
 
 	// check recursion condition
-	if (is_unique == false) {
+	if (is_unique == false && stage != CHECKPOINT_RECURSED) {
+
+#ifdef STATISTICS_COLLECTION
+
+		LoggerPhase phase("recursion", m_level);
+#endif
 
 		if (MAX_MEM >= m_s1->size() * (sizeof(uint32) + sizeof(uint32) + sizeof(uint32) + (double)1 / 8)) {
 
@@ -421,12 +403,119 @@ void DSAComputation<alphabet_type, offset_type>::run() {
 
 			dsac_recurse.run();
 		}
+
+		if (Checkpoint::is_enabled()) saveCheckpoint(CHECKPOINT_RECURSED, is_unique, sa1_reverse);
 	}
 
 	// sort suffixes
 	sortSuffixGlobal(sa1_reverse);
 }
 
+/// \brief write the manifest of the level, the files of _vec are pinned for resuming
+///
+/// \note the files of the replaced manifest and the manifests of deeper levels are removed once the new manifest is in place, 
+/// because they are consumed by then
+template<typename alphabet_type, typename offset_type>
+void DSAComputation<alphabet_type, offset_type>::saveCheckpoint(const uint8 _stage, const bool _is_unique, offset_vector_type * _vec) {
+
+	const std::string fname = Checkpoint::manifestName(m_level), tmp_fname = fname + ".tmp";
+
+	const std::vector<std::string> replaced_files = Checkpoint::manifestFiles(fname);
+
+	std::ofstream fout(tmp_fname.c_str());
+
+	if (!fout) {
+
+		std::cerr << "fail to create " << tmp_fname << "\n";
+
+		exit(-1);
+	}
+
+	Checkpoint::writeHeader(fout, _stage, m_s_len, sizeof(alphabet_type), sizeof(offset_type));
+
+	fout << _is_unique << " " << m_blocks_info.size() << "\n";
+
+	for (uint32 i = 0; i < m_blocks_info.size(); ++i) {
+
+		const BlockInfo & block_info = m_blocks_info[i];
+
+		fout << block_info.m_capacity << " " << block_info.m_beg_pos << " " << block_info.m_end_pos << " " << block_info.m_size << " " << block_info.m_lms_num << " " << static_cast<uint32>(block_info.m_id) << "\n";
+	}
+
+	_vec->save(fout);
+
+	fout.close();
+
+	// replace the previous manifest only if the new one is complete
+	if (!fout || std::rename(tmp_fname.c_str(), fname.c_str()) != 0) {
+
+		std::cerr << "fail to write " << fname << "\n";
+
+		exit(-1);
+	}
+
+	Checkpoint::removeFiles(replaced_files, Checkpoint::manifestFiles(fname));
+
+	Checkpoint::removeFrom(m_level + 1);
+}
+
+/// \brief restore the level from its manifest, m_s1 is restored for CHECKPOINT_REDUCED and _sa1_reverse for CHECKPOINT_RECURSED
+///
+/// \return stage of the manifest, CHECKPOINT_NONE with a warning if no manifest matches the current run or a kept file is missing
+template<typename alphabet_type, typename offset_type>
+uint8 DSAComputation<alphabet_type, offset_type>::restoreCheckpoint(bool & _is_unique, offset_vector_type *& _sa1_reverse) {
+
+	const std::string fname = Checkpoint::manifestName(m_level);
+
+	std::ifstream fin(fname.c_str());
+
+	if (!fin) return Checkpoint::reject(m_level, "not found");
+
+	const uint8 stage = Checkpoint::readHeader(fin, m_s_len, sizeof(alphabet_type), sizeof(offset_type));
+
+	if (stage == CHECKPOINT_NONE) return Checkpoint::reject(m_level, "written for another input, width or MAX_MEM");
+
+	uint64 block_num = 0;
+
+	if (!(fin >> _is_unique >> block_num) || block_num == 0 || block_num > std::numeric_limits<uint8>::max() + 1) return Checkpoint::reject(m_level, "broken block partition");
+
+	std::vector<BlockInfo> blocks_info;
+
+	for (uint64 i = 0; i < block_num; ++i) {
+
+		uint64 capacity, beg_pos, end_pos, size, lms_num;
+
+		uint32 id;
+
+		if (!(fin >> capacity >> beg_pos >> end_pos >> size >> lms_num >> id)) return Checkpoint::reject(m_level, "broken block partition");
+
+		BlockInfo block_info(end_pos, id);
+
+		block_info.m_capacity = capacity, block_info.m_beg_pos = beg_pos, block_info.m_size = size, block_info.m_lms_num = lms_num;
+
+		blocks_info.push_back(block_info);
+	}
+
+	offset_vector_type *vec = offset_vector_type::restore(fin);
+
+	if (vec == nullptr) return Checkpoint::reject(m_level, "a kept file is missing or truncated");
+
+	m_blocks_info = blocks_info;
+
+	compute_block_id_of_samplings();
+
+#ifdef STATISTICS_COLLECTION
+
+	Logger::recordBlockNum(m_level, m_blocks_info.size());
+#endif
+
+	if (stage == CHECKPOINT_REDUCED) m_s1 = vec; else _sa1_reverse = vec;
+
+	std::cerr << "resume level " << m_level << " from " << fname << (stage == CHECKPOINT_REDUCED ? " (S*-substrs sorted)" : " (recursion returned)") << "\n";
+
+	return stage;
+}
+
 /// \brief sort S*-substrs
 ///
 template<typename alphabet_type, typename offset_type>
@@ -502,6 +591,11 @@ bool DSAComputation<alphabet_type, offset_type>::sortSStarGlobal() {
 template<typename alphabet_type, typename offset_type>
 uint64 DSAComputation<alphabet_type, offset_type>::partitionS() {
 
+#ifdef STATISTICS_COLLECTION
+
+	LoggerPhase phase("partition s", m_level);
+#endif
+
 	std::cerr << "partition is started\n";
 
 	// scan s leftward to find all the S*-substrs
@@ -581,6 +675,11 @@ uint64 DSAComputation<alphabet_type, offset_type>::partitionS() {
 
 	compute_block_id_of_samplings(); // compute block_id for samplings
 
+#ifdef STATISTICS_COLLECTION
+
+	Logger::recordBlockNum(m_level, m_blocks_info.size());
+#endif
+
 	std::cerr << "partition is over\n";
 
 	return lms_num;
@@ -662,6 +761,11 @@ uint8 DSAComputation<alphabet_type, offset_type>::getBlockId(const offset_type &
 template<typename alphabet_type, typename offset_type>
 void DSAComputation<alphabet_type, offset_type>::sortSStarBlock(const BlockInfo & _block_info) {
 
+#ifdef STATISTICS_COLLECTION
+
+	LoggerPhase phase("sort S*-substrs in a block", m_level);
+#endif
+
 	if (_block_info.is_single() == true) {
 
 		sortSStarSingleBlock(_block_info);
@@ -669,7 +773,7 @@ void DSAComputation<alphabet_type, offset_type>::sortSStarBlock(const BlockInfo
 
 	if (_block_info.is_multi() == true) {
 
-		if (sizeof(alphabet_type) <= sizeof(uint32)) {
+		if (sizeof(alphabet_type) < sizeof(uint32)) { // bucket array of size ALPHA_MAX + 1 is affordable
 
 			sortSStarMultiBlock<false>(_block_info);
 		}
@@ -1010,6 +1114,11 @@ void DSAComputation<alphabet_type, offset_type>::formatMultiBlock(const BlockInf
 template<typename alphabet_type, typename offset_type>
 bool DSAComputation<alphabet_type, offset_type>::mergeSortedSStarGlobal() {
 
+#ifdef STATISTICS_COLLECTION
+
+	LoggerPhase phase("merge sorted S*-substrs", m_level);
+#endif
+
 	// sort the ending characters of S*-substrs
 	typedef Pair<alphabet_type, offset_type> pair_type; // <ch, pos>
 	
@@ -1657,9 +1766,14 @@ void DSAComputation<alphabet_type, offset_type>::sortSuffixGlobal(offset_vector_
 
 	for (uint8 i = 0; i < m_blocks_info.size(); ++i) {
 
+#ifdef STATISTICS_COLLECTION
+
+		LoggerPhase phase("induce suffixes in a block", m_level);
+#endif
+
 		if (m_blocks_info[i].is_multi()) {
 
-			if (sizeof(alphabet_type) <= sizeof(uint32)) { 
+			if (sizeof(alphabet_type) < sizeof(uint32)) { 
 			
 				sortSuffixMultiBlock<false>(m_blocks_info[i]); 
 			}
@@ -1986,6 +2100,11 @@ void DSAComputation<alphabet_type, offset_type>::sortSuffixMultiBlock(const Bloc
 template<typename alphabet_type, typename offset_type>
 void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 
+#ifdef STATISTICS_COLLECTION
+
+	LoggerPhase phase((m_level == 0) ? "final merge" : "merge sorted suffixes", m_level);
+#endif
+
 	// sort S*-suffixes
 	typedef Triple<offset_type, alphabet_type, offset_type> triple_type; // <rank, ch, pos>
 	
@@ -2066,12 +2185,24 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 
 	typedef PQL_SUF<alphabet_type, offset_type, triple_type2, triple_comparator_type2> heap_type;
 
-	heap_type *pq_l = new heap_type(MAX_MEM);
+	// RAM for the heaps, leaving out the RAM taken by the sink (at least a quarter of MAX_MEM is kept for the heaps)
+	const uint64 sink_mem = (m_sink != nullptr) ? m_sink->mem_usage() : 0;
+
+	const uint64 pq_mem = (sink_mem < MAX_MEM / 4 * 3) ? MAX_MEM - sink_mem : MAX_MEM / 4;
+
+	heap_type *pq_l = new heap_type(pq_mem);
 
 	alphabet_vector_type *sorted_l_ch = new alphabet_vector_type();
 
 	offset_vector_type *sorted_l_pos = new offset_vector_type();
 
+	// preceding characters of L-type suffixes and S*-suffixes at block ends, only for producing BWT
+	const bool bwt_required = (m_sink != nullptr && m_sink->is_bwt_required());
+
+	alphabet_vector_type *sorted_l_bwt = bwt_required ? new alphabet_vector_type() : nullptr;
+
+	alphabet_vector_type *sorted_lms_bwt = bwt_required ? new alphabet_vector_type() : nullptr;
+
 	for (uint8 i = 0; i < m_blocks_info.size(); ++i) {
 
 		m_suf_l_bwt_seqs[i]->start_read();
@@ -2093,9 +2224,11 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 
 				uint8 block_id = getBlockId(cur_str.second);
 
+				alphabet_type pre_ch = 0; // the sentinel precedes s[0]
+
 				if (OFFSET_MIN != cur_str.second) {
 
-					alphabet_type pre_ch = m_suf_l_bwt_seqs[block_id]->get();
+					pre_ch = m_suf_l_bwt_seqs[block_id]->get();
 
 					m_suf_l_bwt_seqs[block_id]->next_remove();
 
@@ -2105,6 +2238,8 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 					}
 				}
 
+				if (sorted_l_bwt != nullptr) sorted_l_bwt->push_back(pre_ch);
+
 				sorted_l_ch->push_back(cur_str.first);
 
 				sorted_l_pos->push_back(cur_str.second);
@@ -2127,6 +2262,11 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 
 				pq_l->push(triple_type2(pre_ch, name_cnt, cur_str.third - 1));
 
+				if (sorted_lms_bwt != nullptr && m_blocks_info[block_id].m_end_pos == cur_str.third) {
+
+					sorted_lms_bwt->push_back(pre_ch); // not available when inducing S-type suffixes
+				}
+
 				name_cnt = name_cnt + 1;
 			}
 
@@ -2185,7 +2325,7 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 	
 	typedef PQS_SUF<alphabet_type, offset_type, triple_type2, triple_comparator_type3> heap_type2;
 
-	heap_type2 *pq_s = new heap_type2(MAX_MEM);
+	heap_type2 *pq_s = new heap_type2(pq_mem);
 
 	std::vector<bool> is_l_star(m_blocks_info.size());
 
@@ -2193,6 +2333,13 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 
 	sorted_l_pos->start_read_reverse();
 
+	if (bwt_required) {
+
+		sorted_l_bwt->start_read_reverse();
+
+		sorted_lms_bwt->start_read_reverse();
+	}
+
 	for (uint8 i = 0; i < m_blocks_info.size(); ++i) {
 
 		m_suf_s_bwt_seqs[i]->start_read();
@@ -2208,7 +2355,7 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 	}
 
 	{
-		m_sa_reverse = new offset_vector_type();
+		if (m_sink == nullptr) m_sa_reverse = new offset_vector_type();
 
 		alphabet_type cur_bkt = sorted_l_ch->get_reverse();
 
@@ -2225,9 +2372,11 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 
 				uint8 block_id = getBlockId(cur_str.second);
 
+				alphabet_type pre_ch = 0; // the sentinel precedes s[0]
+
 				if (m_blocks_info[block_id].m_end_pos != cur_str.second && OFFSET_MIN != cur_str.second) {
 
-					alphabet_type pre_ch = m_suf_s_bwt_seqs[block_id]->get();
+					pre_ch = m_suf_s_bwt_seqs[block_id]->get();
 
 					m_suf_s_bwt_seqs[block_id]->next_remove();
 
@@ -2236,8 +2385,21 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 						pq_s->push(triple_type2(pre_ch, name_cnt, cur_str.second - 1));
 					}
 				}
+				else if (bwt_required && OFFSET_MIN != cur_str.second) {
+
+					pre_ch = sorted_lms_bwt->get_reverse();
 
-				m_sa_reverse->push_back(cur_str.second);
+					sorted_lms_bwt->next_remove_reverse();
+				}
+
+				if (m_sink != nullptr) {
+
+					m_sink->push(cur_str.second, pre_ch);
+				}
+				else {
+
+					m_sa_reverse->push_back(cur_str.second);
+				}
 
 				name_cnt = name_cnt - 1;
 			}
@@ -2268,7 +2430,18 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 					}
 				}
 
-				m_sa_reverse->push_back(cur_pos);
+				if (m_sink != nullptr) {
+
+					alphabet_type pre_ch = 0;
+
+					if (bwt_required) pre_ch = sorted_l_bwt->get_reverse(), sorted_l_bwt->next_remove_reverse();
+
+					m_sink->push(cur_pos, pre_ch);
+				}
+				else {
+
+					m_sa_reverse->push_back(cur_pos);
+				}
 
 				name_cnt = name_cnt - 1;
 			}
@@ -2293,7 +2466,28 @@ void DSAComputation<alphabet_type, offset_type>::mergeSortedSuffixGlobal() {
 		}
 	}
 
-	m_sa_reverse->push_back(offset_type(m_s_len - 1));
+	if (m_sink == nullptr) {
+
+		m_sa_reverse->push_back(offset_type(m_s_len - 1));
+	}
+	else if (!bwt_required) {
+
+		m_sink->push(offset_type(m_s_len - 1), alphabet_type(0));
+	}
+	else {
+
+		m_sink->push(offset_type(m_s_len - 1), sorted_lms_bwt->get_reverse()); // the sentinel is the smallest S*-suffix at a block end
+
+		sorted_lms_bwt->next_remove_reverse();
+
+		assert(sorted_l_bwt->is_eof() == true);
+
+		assert(sorted_lms_bwt->is_eof() == true);
+
+		delete sorted_l_bwt; sorted_l_bwt = nullptr;
+
+		delete sorted_lms_bwt; sorted_lms_bwt = nullptr;
+	}
 
 	// clear
 	for (uint8 i = 0; i < m_blocks_info.size(); ++i) {
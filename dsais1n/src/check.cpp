@@ -1,26 +1,86 @@
 #include "common.h"
+#include "metrics.h"
+#include "disks.h"
 #include "checker.h"
+#include "fp_checker.h"
 
 #include <iostream>
 #include <chrono>
 #include <fstream>
+#include <random>
+#include <thread>
+#include <algorithm>
+
+uint64 fp_sample_num = 0; ///< number of sampled pairs for the fingerprint checker, 0 for the full checker
+
+uint64 fp_seed = 0; ///< seed for the fingerprint checker
+
+uint32 thread_num = 1; ///< number of threads for the full checker
+
+/// \brief check the SA whose entries are stored using offset_type
+///
+template<typename alphabet_type, typename offset_type>
+bool check(const std::string & _s_fname, const std::string & _sa_fname) {
+
+	if (fp_sample_num != 0) {
+
+		FingerprintChecker<alphabet_type, offset_type> checker(_s_fname, _sa_fname, fp_sample_num, fp_seed);
+
+		return checker.run();
+	}
+
+	Checker<alphabet_type, offset_type> checker(_s_fname, _sa_fname, thread_num);
+
+	return checker.run();
+}
+
+/// \brief dispatch on the width of SA entries
+///
+template<typename alphabet_type>
+bool check(const uint8 _sa_width, const std::string & _s_fname, const std::string & _sa_fname) {
+
+	switch (_sa_width) {
+
+	case sizeof(uint32): return check<alphabet_type, uint32>(_s_fname, _sa_fname);
+
+	case sizeof(uint40): return check<alphabet_type, uint40>(_s_fname, _sa_fname);
+
+	default: return check<alphabet_type, uint64>(_s_fname, _sa_fname);
+	}
+}
 
 int main(int argc, char** argv){
 
-	// mount stxxl disk	
-	stxxl::config *cfg = stxxl::config::get_instance();
+	// mount stxxl disks, retrieved ahead of the other params
+	mountDisks(argc, argv);
 
-	stxxl::disk_config disk("stxxl.tmp", 1024 * 1024 * 1024, "syscall autogrow unlink");
+	// statistics collection
+	stxxl::stats_data stats_begin(*stxxl::stats::get_instance());
 
-	disk.direct = stxxl::disk_config::DIRECT_ON;
+	const file_stats_list_type file_stats_begin = getFileStats(); // for the per-disk volumes
 
-	cfg->add_disk(disk);
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
 	
 	// check if input params are legal
-	if (argc != 3) {
+	if (argc < 3) {
 
 		std::cerr << "two param required: input_path and output_path.\n";
 
+		std::cerr << "optional param: --alphabet-width 1|2|4 (bytes per character, default: 1).\n";
+
+		std::cerr << "optional param: --fast (probabilistic check by fingerprints and sampled pairs, scanning the input twice and the SA once; "
+			"the permutation and the buckets are verified, the order only for the sampled pairs, not for the full SA).\n";
+
+		std::cerr << "optional param: --samples num (number of sampled pairs for --fast, default: 65536).\n";
+
+		std::cerr << "optional param: --seed num (seed for --fast, default: random).\n";
+
+		std::cerr << "optional param: --threads num (threads for comparing adjacent suffixes in the full check, default: number of cores).\n";
+
+		std::cerr << DISK_USAGE;
+
+		std::cerr << "optional param: --metrics metrics_path (output measurements in JSON, or in CSV if metrics_path ends with .csv).\n";
+
 		exit(-1);
 	}	
 
@@ -29,9 +89,165 @@ int main(int argc, char** argv){
 	
 	// retrieve file name for output SA
 	std::string sa_fname(argv[2]);
-	
-	// compute the SA for the given string
-	Checker<uint8, uint40> checker(s_fname, sa_fname);	
 
-	std::cerr << (checker.run() ? "right" : "wrong")<< std::endl;
+	// retrieve optional params
+	uint8 alphabet_width = sizeof(uint8);
+
+	std::string metrics_fname;
+
+	bool is_fast = false;
+
+	uint64 sample_num = 65536;
+
+	fp_seed = std::random_device()();
+
+	thread_num = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (int i = 3; i < argc; ++i) {
+
+		std::string param(argv[i]);
+
+		if (param == "--alphabet-width" && i + 1 < argc) {
+
+			const uint64 width = parseUInt(param, argv[++i]);
+
+			if (width != sizeof(uint8) && width != sizeof(uint16) && width != sizeof(uint32)) {
+
+				std::cerr << "alphabet width must be 1, 2 or 4.\n";
+
+				exit(-1);
+			}
+
+			alphabet_width = width;
+		}
+		else if (param == "--fast") {
+
+			is_fast = true;
+		}
+		else if (param == "--samples" && i + 1 < argc) {
+
+			sample_num = std::stoull(argv[++i]);
+
+			if (sample_num == 0) {
+
+				std::cerr << "number of samples must be positive.\n";
+
+				exit(-1);
+			}
+		}
+		else if (param == "--seed" && i + 1 < argc) {
+
+			fp_seed = std::stoull(argv[++i]);
+		}
+		else if (param == "--threads" && i + 1 < argc) {
+
+			thread_num = std::stoul(argv[++i]);
+
+			if (thread_num == 0) {
+
+				std::cerr << "number of threads must be positive.\n";
+
+				exit(-1);
+			}
+		}
+		else if (param == "--metrics" && i + 1 < argc) {
+
+			metrics_fname = argv[++i];
+		}
+		else if (param == "--disk" && i + 1 < argc) {
+
+			++i; // mounted already
+		}
+		else {
+
+			std::cerr << "unknown param: " << param << "\n";
+
+			exit(-1);
+		}
+	}
+
+	// compute input string's size
+	std::fstream s_stream(s_fname, std::fstream::in);
+
+	s_stream.seekg(0, std::ios_base::end);
+
+	uint64 s_size = s_stream.tellg() / alphabet_width; // number of characters
+
+	// infer the width of SA entries from the file sizes
+	std::fstream sa_stream(sa_fname, std::fstream::in);
+
+	sa_stream.seekg(0, std::ios_base::end);
+
+	uint64 sa_size = sa_stream.tellg();
+
+	if (s_size == 0 || sa_size % s_size != 0) {
+
+		std::cerr << "sa size does not match s size.\n";
+
+		exit(-1);
+	}
+
+	uint64 sa_width = sa_size / s_size;
+
+	if (sa_width != sizeof(uint32) && sa_width != sizeof(uint40) && sa_width != sizeof(uint64)) {
+
+		std::cerr << "sa width must be 4, 5 or 8.\n";
+
+		exit(-1);
+	}
+
+	if (is_fast) fp_sample_num = sample_num;
+
+	// check the SA for the given string
+	bool is_right = false;
+
+	switch (alphabet_width) {
+
+	case sizeof(uint8): is_right = check<uint8>(sa_width, s_fname, sa_fname); break;
+
+	case sizeof(uint16): is_right = check<uint16>(sa_width, s_fname, sa_fname); break;
+
+	default: is_right = check<uint32>(sa_width, s_fname, sa_fname); break;
+	}
+
+	std::cerr << (is_right ? "right" : "wrong") << std::endl;
+
+	if (is_right && is_fast) std::cerr << "note: --fast does not verify the full order, only the sampled pairs are compared.\n";
+
+	// output report
+	reportDisks(stats_begin, file_stats_begin);
+
+	// output measurements
+	if (!metrics_fname.empty()) {
+
+		Metrics metrics;
+
+		metrics.addString("program", "check");
+
+		metrics.addString("input", s_fname);
+
+		metrics.addInteger("input_size", s_size);
+
+		metrics.addInteger("alphabet_width", alphabet_width);
+
+		metrics.addInteger("sa_width", sa_width);
+
+		metrics.addInteger("max_mem", MAX_MEM);
+
+		metrics.addString("mode", is_fast ? "fingerprint" : "full");
+
+		if (!is_fast) metrics.addInteger("threads", thread_num);
+
+		metrics.addBool("right", is_right);
+
+		metrics.addBool("order_verified", !is_fast); // --fast compares sampled pairs only
+
+		metrics.addReal("elapsed_time", std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+		addStxxlMetrics(metrics, stats_begin, s_size);
+
+		addDiskMetrics(metrics, file_stats_begin);
+
+		metrics.write(metrics_fname);
+	}
 }
@@ -6,8 +6,89 @@
 #include "tuple_sorter.h"
 #include "io.h"
 
+#include <future>
+#include <vector>
+#include <algorithm>
+
+/// \brief read a file-backed vector in batches, the next batch is read on a background thread while the current one is consumed
+///
+template<typename vector_type, typename element_type>
+class BatchReader{
+
+private:
+
+	stxxl::syscall_file *m_file;
+
+	vector_type *m_vec;
+
+	typename vector_type::const_iterator m_it; ///< next element to be read
+
+	std::vector<element_type> m_batch[2]; ///< double buffer
+
+	uint8 m_cur; ///< index of the batch being consumed
+
+	std::future<void> m_pending; ///< reading of the next batch
+
+	const uint64 m_batch_capacity; ///< number of elements in each batch
+
+public:
+
+	/// \brief ctor, start reading the first batch
+	///
+	BatchReader(const std::string & _fname, const uint64 _batch_capacity) : m_cur(0), m_batch_capacity(_batch_capacity) {
+
+		m_file = new stxxl::syscall_file(_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+
+		m_vec = new vector_type(m_file);
+
+		m_it = m_vec->begin();
+
+		m_pending = std::async(std::launch::async, &BatchReader::fill, this, 1);
+	}
+
+	/// \brief dtor
+	///
+	~BatchReader() {
+
+		if (m_pending.valid()) m_pending.wait();
+
+		delete m_vec; m_vec = nullptr;
+
+		delete m_file; m_file = nullptr;
+	}
+
+	/// \brief retrieve the next batch, the previous batch is invalidated
+	///
+	/// \return an empty batch if no more elements
+	const std::vector<element_type> & next() {
+
+		if (m_pending.valid()) m_pending.get(); else m_batch[1 - m_cur].clear();
+
+		m_cur = 1 - m_cur;
+
+		if (!m_batch[m_cur].empty()) m_pending = std::async(std::launch::async, &BatchReader::fill, this, 1 - m_cur);
+
+		return m_batch[m_cur];
+	}
+
+private:
+
+	/// \brief fill the specified batch
+	///
+	void fill(const uint8 _idx) {
+
+		m_batch[_idx].clear();
+
+		for (; m_it != m_vec->end() && m_batch[_idx].size() < m_batch_capacity; ++m_it) m_batch[_idx].push_back(*m_it);
+	}
+};
+
 /// \brief perform checking after construction
 ///
+/// Two sorters are applied: <sa[i], i> is sorted by sa[i] to produce <isa[j], s[j], isa[j + 1]>, which is sorted by isa[j].
+/// The runs of the sorters are formed and merged by stxxl, in parallel if stxxl is built with its parallel mode.
+/// The input string and SA are read on background threads while the elements are pushed into the sorters.
+/// The final comparison of adjacent suffixes is done batch by batch, a batch is split into slices checked in parallel while the next batch is merged.
 template<typename alphabet_type, typename offset_type>
 class Checker{
 
@@ -17,18 +98,24 @@ private:
 
 	typedef typename ExVector<offset_type>::vector offset_vector_type; 
 
+	typedef Triple<offset_type, alphabet_type, offset_type> triple_type; ///< <isa[j], s[j], isa[j + 1]>
+
 private:
 
 	std::string m_s_fname;
 
 	std::string m_sa_fname;
 
+	const uint32 m_thread_num; ///< number of threads for comparing adjacent suffixes
+
+	const uint64 m_batch_capacity; ///< number of elements in a batch
+
 public:
 
 	/// \brief ctor
 	///
-	Checker(const std::string & _s_fname, const std::string & _sa_fname) :
-		m_s_fname(_s_fname), m_sa_fname(_sa_fname) {}
+	Checker(const std::string & _s_fname, const std::string & _sa_fname, const uint32 _thread_num = 1) :
+		m_s_fname(_s_fname), m_sa_fname(_sa_fname), m_thread_num(std::max(_thread_num, uint32(1))), m_batch_capacity(MAX_MEM / 32 / sizeof(triple_type)) {}
 
 
 	/// \brief check
@@ -44,134 +131,172 @@ public:
 
 		sorter_type *sorter = new sorter_type(pair_comparator_type(), MAX_MEM / 2);
 
-		stxxl::syscall_file *sa_file = new stxxl::syscall_file(m_sa_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
-
-		offset_vector_type *sa = new offset_vector_type(sa_file);
+		{
+			BatchReader<offset_vector_type, offset_type> sa_reader(m_sa_fname, m_batch_capacity);
 
-		typename offset_vector_type::const_iterator it = sa->begin();
+			offset_type i = 1; // start ranking from 1 (0 is reserved for the sentinel)
 
-		for (offset_type i = 1; it != sa->end(); ++it, ++i) {
+			for (const std::vector<offset_type> *batch = &sa_reader.next(); !batch->empty(); batch = &sa_reader.next()) {
 
-			sorter->push(pair_type(*it, i)); // start ranking from 1 (0 is reserved for the sentinel)
+				for (uint64 k = 0; k < batch->size(); ++k, ++i) sorter->push(pair_type((*batch)[k], i));
+			}
 		}
 
-		delete sa; sa = nullptr;
-
-		delete sa_file; sa_file = nullptr;
-
 		sorter->sort();
 
 		// sort <isa[i], s[i], isa[i + 1]> by isa[i]
-		typedef Triple<offset_type, alphabet_type, offset_type> triple_type;
-
 		typedef TupleAscCmp1<triple_type> triple_comparator_type;
 
 		typedef typename ExSorter<triple_type, triple_comparator_type>::sorter sorter_type2;
 
 		sorter_type2 *sorter2 = new sorter_type2(triple_comparator_type(), MAX_MEM / 2);
 
-		stxxl::syscall_file *s_file = new stxxl::syscall_file(m_s_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+		{
+			BatchReader<alphabet_vector_type, alphabet_type> s_reader(m_s_fname, m_batch_capacity);
+
+			const std::vector<alphabet_type> *batch = &s_reader.next();
+
+			uint64 k = 0;
 
-		alphabet_vector_type *s = new alphabet_vector_type(s_file);
+			alphabet_type cur_ch;
 
-		typename alphabet_vector_type::const_iterator it2 = s->begin();
+			offset_type cur_rank, next_rank;
 
-		alphabet_type cur_ch;
+			offset_type cur_pos, next_pos;
 
-		offset_type cur_rank, next_rank;
+			cur_rank = (*sorter)->second, cur_pos = (*sorter)->first, ++(*sorter);
 
-		offset_type cur_pos, next_pos;
+			offset_type i = 0;
 
-		cur_rank = (*sorter)->second, cur_pos = (*sorter)->first, ++(*sorter);
+			for (; ; ++(*sorter), ++i) {
+
+				if (cur_pos != i) { // the last one is also checked
+				
+					std::cerr << "not a permutation\n";
+
+					delete sorter; sorter = nullptr;
+
+					delete sorter2; sorter2 = nullptr;
+
+					return false;
+				}
 
-		for (offset_type i = 0; !sorter->empty(); ++it2, ++(*sorter), ++i) {
+				if (sorter->empty()) break;
 
-			if (cur_pos != i) {
-			
-				std::cerr << "not a permutation\n";
+				if (k == batch->size()) batch = &s_reader.next(), k = 0;
 
-				return false;
+				cur_ch = (*batch)[k++], next_rank = (*sorter)->second, next_pos = (*sorter)->first;
+
+				sorter2->push(triple_type(cur_rank, cur_ch, next_rank));
+
+				cur_rank = next_rank, cur_pos = next_pos;
 			}
 
-			cur_ch = *it2, next_rank = (*sorter)->second, next_pos = (*sorter)->first;
+			if (k == batch->size()) batch = &s_reader.next(), k = 0;
 
-			sorter2->push(triple_type(cur_rank, cur_ch, next_rank));
+			cur_ch = (*batch)[k], next_rank = offset_type(0); // the rank of the sentinel is set to 0
 
-			cur_rank = next_rank, cur_pos = next_pos;
+			sorter2->push(triple_type(cur_rank, cur_ch, next_rank));
 		}
 
-		cur_ch = *it2, next_rank = offset_type(0); // the rank of the sentinel is set to 0
+		delete sorter; sorter = nullptr;
+
+		sorter2->sort();
 
-		sorter2->push(triple_type(cur_rank, cur_ch, next_rank));
+		// scan to check the result, batch by batch
+		std::vector<triple_type> batch[2];
 
-		delete sorter; sorter = nullptr;
+		std::future<uint64> pending; // rank of the first unordered pair in the previous batch, 0 if none
 
-		delete s; s = nullptr;
+		uint64 wrong_rank = 0;
 
-		delete s_file; s_file = nullptr;
-		
-		sorter2->sort();
+		for (uint8 cur = 0; ; cur = 1 - cur) {
 
-		// scan to check the result
-		{
+			batch[cur].clear();
 
-			stxxl::syscall_file *sa_file = new stxxl::syscall_file(m_sa_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+			if (!batch[1 - cur].empty()) batch[cur].push_back(batch[1 - cur].back()); // the last element of the previous batch is compared with the first of the current
 
-			offset_vector_type *sa = new offset_vector_type(sa_file);
+			for (; !sorter2->empty() && batch[cur].size() < m_batch_capacity; ++(*sorter2)) batch[cur].push_back(**sorter2);
 
-			typename offset_vector_type::const_iterator it = sa->begin();
-				
-			alphabet_type last_ch, cur_ch;
+			if (pending.valid() && (wrong_rank = pending.get()) != 0) break;
+
+			if (batch[cur].size() <= 1) break;
 
-			offset_type last_rank, cur_rank;
+			pending = std::async(std::launch::async, &Checker::checkBatch, this, &batch[cur]);
+		}
 
-			offset_type last_suc_rank, cur_suc_rank;
+		if (wrong_rank == 0 && pending.valid()) wrong_rank = pending.get();
 
-			offset_type last_pos, cur_pos;
+		delete sorter2; sorter2 = nullptr;
 
-			last_rank = (*sorter2)->first, last_ch = (*sorter2)->second, last_suc_rank = (*sorter2)->third, ++(*sorter2);
+		if (wrong_rank != 0) {
 
-			last_pos = *it, ++it;
+			report(wrong_rank);
 
-			for (; !sorter2->empty(); ++(*sorter2), ++it) {
+			return false;
+		}
 
-				cur_rank = (*sorter2)->first, cur_ch = (*sorter2)->second, cur_suc_rank = (*sorter2)->third;
-			
-				cur_pos = *it;
+		return true;
+	}
 
-				if (last_ch > cur_ch || (last_ch == cur_ch && last_suc_rank > cur_suc_rank)) {
+private:
 
-					std::cerr << "last_rank: " << last_rank << " ";
+	/// \brief check if the adjacent elements in the batch are ordered by <ch, isa[j + 1]>, the batch is split into slices checked in parallel
+	///
+	/// \return rank of the first unordered pair (the larger rank), 0 if none
+	uint64 checkBatch(const std::vector<triple_type> * _batch) {
 
-					std::cerr << "last_ch: " << (uint32)last_ch << " ";
+		const uint64 slice_size = (_batch->size() + m_thread_num - 1) / m_thread_num;
 
-					std::cerr << "last_suc_rank: " << last_suc_rank << " ";
+		std::vector<std::future<uint64>> slices;
 
-					std::cerr << "last_pos: " << last_pos << std::endl;
+		for (uint64 beg = 0; beg + 1 < _batch->size(); beg += slice_size) {
 
-					std::cerr << "cur_rank: " << cur_rank << " ";
-				
-					std::cerr << "cur_ch: " << (uint32)cur_ch << " ";
+			const uint64 end = std::min(beg + slice_size + 1, uint64(_batch->size())); // overlap by one element
 
-					std::cerr << "cur_suc_rank: " << cur_suc_rank << " ";
+			slices.push_back(std::async(std::launch::async, &Checker::checkSlice, _batch, beg, end));
+		}
 
-					std::cerr << "cur_pos: " << cur_pos << std::endl;
+		uint64 wrong_rank = 0;
 
-					return false;	
-				}
+		for (uint64 i = 0; i < slices.size(); ++i) {
+
+			const uint64 rank = slices[i].get();
+
+			if (wrong_rank == 0) wrong_rank = rank;
+		}
 
-				last_rank = cur_rank, last_ch = cur_ch, last_suc_rank = cur_suc_rank, last_pos = cur_pos;
-			}	
+		return wrong_rank;
+	}
 
-			delete sorter2; sorter2 = nullptr;
+	/// \brief check if the adjacent elements in [_beg, _end) are ordered
+	///
+	static uint64 checkSlice(const std::vector<triple_type> * _batch, const uint64 _beg, const uint64 _end) {
 
-			delete sa; sa = nullptr;
+		for (uint64 i = _beg + 1; i < _end; ++i) {
 
-			delete sa_file; sa_file = nullptr;
+			const triple_type & last = (*_batch)[i - 1], & cur = (*_batch)[i];
 
-			return true;
+			if (last.second > cur.second || (last.second == cur.second && last.third > cur.third)) return cur.first;
 		}
 
+		return 0;
+	}
+
+	/// \brief report an unordered pair of adjacent suffixes
+	///
+	/// \note ranks start from 1, sa[_rank - 1] is the suffix of _rank
+	void report(const uint64 _rank) {
+
+		stxxl::syscall_file *sa_file = new stxxl::syscall_file(m_sa_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+
+		offset_vector_type *sa = new offset_vector_type(sa_file);
+
+		std::cerr << "suffixes out of order: sa[" << _rank - 2 << "] = " << (*sa)[_rank - 2] << ", sa[" << _rank - 1 << "] = " << (*sa)[_rank - 1] << std::endl;
+
+		delete sa; sa = nullptr;
+
+		delete sa_file; sa_file = nullptr;
 	}
 };
 
@@ -0,0 +1,303 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file checkpoint.h
+/// \brief Checkpoints between the phases of DSA-IS, for resuming an interrupted build.
+///
+/// A manifest dsais1n_checkpoint_<level>.txt is written for a recursion level
+/// after its S*-substrs are sorted (the reduced string is kept) and after its recursion returns (the SA of the reduced string is kept).
+/// A manifest records the block partition of the level and the layout of the kept vector, whose files are reused on resuming.
+/// The files of a manifest are pinned, i.e., reading them never removes them, so a manifest stays usable until it is replaced.
+/// They are removed together with the manifest: when the level writes a newer manifest, 
+/// and when a level moves forward, for the manifests of deeper levels.
+/// Manifests and temporary files are created in the working directory, the build must be resumed in the same directory.
+///////////////////////////////////////////////////////////
+
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+
+#include "common.h"
+#include "logger.h"
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include <dirent.h>
+
+constexpr uint32 CHECKPOINT_VERSION = 1; ///< format version of the manifests
+
+/// \brief stages of a recursion level recorded by a manifest
+///
+enum CheckpointStage{
+
+	CHECKPOINT_NONE, ///< no checkpoint
+
+	CHECKPOINT_REDUCED, ///< S*-substrs are sorted, the reduced string is kept
+
+	CHECKPOINT_RECURSED ///< the recursion returns, the SA of the reduced string is kept
+};
+
+/// \brief settings and manifest management of checkpoints
+///
+class Checkpoint{
+
+private:
+
+	static bool enabled; ///< write checkpoints
+
+	static bool resume; ///< reuse checkpoints of a previous run
+
+	static std::string input_fname; ///< input string
+
+	static uint64 input_size; ///< size of the input file (in bytes)
+
+	static std::vector<std::string> kept_files; ///< temporary files kept by the manifests of a previous run
+
+public:
+
+	/// \brief enable checkpoints, reuse those of a previous run if _resume is true
+	///
+	static void enable(const bool _resume) {
+
+		enabled = true, resume = _resume;
+	}
+
+	/// \brief check if checkpoints are enabled
+	///
+	static bool is_enabled() {
+
+		return enabled;
+	}
+
+	/// \brief prepare for a run, call the function before creating any temporary file
+	///
+	/// On resuming, temporary files are numbered after those kept by the manifests, and those not kept by any manifest are removed.
+	/// Otherwise, manifests of a previous run are removed.
+	static void prepare(const std::string & _input_fname) {
+
+		if (!enabled) return;
+
+		input_fname = _input_fname, input_size = 0;
+
+		FILE *file = fopen(_input_fname.c_str(), "rb");
+
+		if (file != nullptr) {
+
+			fseek(file, 0, SEEK_END);
+
+			input_size = ftell(file);
+
+			fclose(file);
+		}
+
+		if (!resume) {
+
+			removeFrom(0);
+
+			return;
+		}
+
+		uint32 next_file_idx = 0;
+
+		for (uint32 level = 0; ; ++level) {
+
+			std::ifstream fin(manifestName(level).c_str());
+
+			std::string tag, token;
+
+			uint32 version, file_idx;
+
+			if (!(fin >> tag >> version >> file_idx) || tag != "dsais1n_checkpoint" || version != CHECKPOINT_VERSION) break;
+
+			next_file_idx = std::max(next_file_idx, file_idx);
+
+			while (fin >> token) {
+
+				if (is_temp_file(token)) kept_files.push_back(token);
+			}
+		}
+
+		global_file_idx = next_file_idx;
+
+		removeTempFiles();
+	}
+
+	/// \brief remove all the manifests and their files after a successful run
+	///
+	/// \note kept_files also covers the files of manifests found invalid on resuming
+	static void finish() {
+
+		if (!enabled) return;
+
+		removeFrom(0);
+
+		for (size_t i = 0; i < kept_files.size(); ++i) std::remove(kept_files[i].c_str());
+
+		kept_files.clear();
+	}
+
+	/// \brief name of the manifest for the given level
+	///
+	static std::string manifestName(const uint32 _level) {
+
+		return "dsais1n_checkpoint_" + std::to_string(_level) + ".txt";
+	}
+
+	/// \brief remove the manifests of the given level and the deeper ones, together with their files
+	///
+	/// \note manifests exist for consecutive levels starting from 0
+	static void removeFrom(const uint32 _level) {
+
+		for (uint32 level = _level; ; ++level) {
+
+			const std::vector<std::string> fnames = manifestFiles(manifestName(level));
+
+			if (std::remove(manifestName(level).c_str()) != 0) break;
+
+			removeFiles(fnames);
+		}
+	}
+
+	/// \brief temporary files kept by a manifest, empty if the manifest does not exist
+	///
+	static std::vector<std::string> manifestFiles(const std::string & _fname) {
+
+		std::vector<std::string> fnames;
+
+		std::ifstream fin(_fname.c_str());
+
+		std::string token;
+
+		while (fin >> token) {
+
+			if (is_temp_file(token)) fnames.push_back(token);
+		}
+
+		return fnames;
+	}
+
+	/// \brief remove temporary files released by a manifest, except for those in _kept
+	///
+	static void removeFiles(const std::vector<std::string> & _fnames, const std::vector<std::string> & _kept = std::vector<std::string>()) {
+
+		for (size_t i = 0; i < _fnames.size(); ++i) {
+
+			if (std::find(_kept.begin(), _kept.end(), _fnames[i]) != _kept.end()) continue;
+
+			FILE *file = fopen(_fnames[i].c_str(), "rb");
+
+			if (file == nullptr) continue;
+
+			fseek(file, 0, SEEK_END);
+
+#ifdef STATISTICS_COLLECTION
+			Logger::delPDU(ftell(file));
+#endif
+
+			fclose(file);
+
+			std::remove(_fnames[i].c_str());
+		}
+	}
+
+	/// \brief warn that the manifest of a level cannot be reused
+	///
+	/// \return CHECKPOINT_NONE
+	static uint8 reject(const uint32 _level, const std::string & _reason) {
+
+		std::cerr << "warning: " << manifestName(_level) << " is not reused (" << _reason << "), level " << _level << " is computed from scratch\n";
+
+		return CHECKPOINT_NONE;
+	}
+
+	/// \brief write the header of a manifest
+	///
+	static void writeHeader(std::ostream & _out, const uint8 _stage, const uint64 _s_len, const uint8 _alphabet_width, const uint8 _offset_width) {
+
+		_out << "dsais1n_checkpoint " << CHECKPOINT_VERSION << " " << global_file_idx << "\n";
+
+		_out << input_size << " " << input_fname << "\n";
+
+		_out << static_cast<uint32>(_stage) << " " << _s_len << " " << static_cast<uint32>(_alphabet_width) << " " << static_cast<uint32>(_offset_width) << " " << MAX_MEM << "\n";
+	}
+
+	/// \brief read the header of a manifest and check if it matches the current run
+	///
+	/// \return stage of the manifest, CHECKPOINT_NONE if not matched
+	static uint8 readHeader(std::istream & _in, const uint64 _s_len, const uint8 _alphabet_width, const uint8 _offset_width) {
+
+		std::string tag, fname;
+
+		uint32 version, file_idx, stage, alphabet_width, offset_width;
+
+		uint64 size, s_len, max_mem;
+
+		if (!(_in >> tag >> version >> file_idx >> size) || tag != "dsais1n_checkpoint" || version != CHECKPOINT_VERSION) return CHECKPOINT_NONE;
+
+		_in.get(), std::getline(_in, fname);
+
+		if (!(_in >> stage >> s_len >> alphabet_width >> offset_width >> max_mem)) return CHECKPOINT_NONE;
+
+		if (size != input_size || fname != input_fname || s_len != _s_len || alphabet_width != _alphabet_width || offset_width != _offset_width || max_mem != MAX_MEM) return CHECKPOINT_NONE;
+
+		return (stage == CHECKPOINT_REDUCED || stage == CHECKPOINT_RECURSED) ? static_cast<uint8>(stage) : static_cast<uint8>(CHECKPOINT_NONE);
+	}
+
+	/// \brief check if manifests of a previous run should be reused
+	///
+	static bool is_resuming() {
+
+		return enabled && resume;
+	}
+
+private:
+
+	/// \brief check if a file name is that of a temporary file created by MyVector
+	///
+	static bool is_temp_file(const std::string & _fname) {
+
+		unsigned int file_idx;
+
+		char suffix[8];
+
+		return sscanf(_fname.c_str(), "tmp_dsais1n_%u.%7s", &file_idx, suffix) == 2 && std::string(suffix) == "dat";
+	}
+
+	/// \brief remove temporary files in the working directory not kept by any manifest, they are left by the interrupted run
+	///
+	static void removeTempFiles() {
+
+		DIR *dir = opendir(".");
+
+		if (dir == nullptr) return;
+
+		for (struct dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+
+			const std::string fname(entry->d_name);
+
+			if (is_temp_file(fname) && std::find(kept_files.begin(), kept_files.end(), fname) == kept_files.end()) {
+
+				std::remove(fname.c_str());
+			}
+		}
+
+		closedir(dir);
+	}
+};
+
+bool Checkpoint::enabled = false;
+
+bool Checkpoint::resume = false;
+
+std::string Checkpoint::input_fname;
+
+uint64 Checkpoint::input_size = 0;
+
+std::vector<std::string> Checkpoint::kept_files;
+
+#endif // _CHECKPOINT_H
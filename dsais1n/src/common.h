@@ -22,6 +22,11 @@
 #include <limits>
 #include <vector>
 #include <utility>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cctype>
+#include <stdexcept>
 
 
 
@@ -36,6 +41,29 @@ using uint64 = stxxl::uint64;
 
 using uint40 = stxxl::uint40;
 
+/// \brief parse the unsigned integer given to a command-line param, exit if it is not a number or out of range
+///
+inline uint64 parseUInt(const std::string & _param, const std::string & _value) {
+
+	size_t len = 0;
+
+	uint64 val = 0;
+
+	if (!_value.empty() && std::isdigit(static_cast<unsigned char>(_value[0]))) {
+
+		try { val = std::stoull(_value, &len); } catch (const std::exception &) { len = 0; }
+	}
+
+	if (len == 0 || len != _value.size()) {
+
+		std::cerr << "illegal value for " << _param << ": " << _value << "\n";
+
+		exit(-1);
+	}
+
+	return val;
+}
+
 // L-type and S-type 
 constexpr uint8 L_TYPE = 0;
 
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file disks.h
+/// \brief Scratch disks for stxxl given on the command line.
+///
+/// A disk is given by --disk path[,size[,io_impl[,direct]]], the param may be repeated to stripe blocks over several disks.
+/// size is the initial size in MB (default: 1024), a disk grows on demand and is removed on exit.
+/// io_impl is one of syscall, linuxaio and memory (default: syscall).
+/// direct is one of try, on and off (default: try), try falls back to buffered I/O if the file system does not support direct I/O (e.g., tmpfs).
+/// If no disk is given, stxxl.tmp in the working directory is used.
+///
+/// The disks must be mounted before the block manager is created,
+/// so they are retrieved by scanning the params ahead of the others.
+///////////////////////////////////////////////////////////
+
+#ifndef _DISKS_H
+#define _DISKS_H
+
+#include "common.h"
+#include "metrics.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#define DISK_DEFAULT_PATH "stxxl.tmp"
+
+#define DISK_DEFAULT_SIZE 1024 ///< initial size in MB
+
+#define DISK_USAGE "optional param: --disk path[,size[,syscall|linuxaio|memory[,try|on|off]]] (scratch disk with its initial size in MB, I/O implementation and direct I/O, repeatable, default: stxxl.tmp,1024,syscall,try).\n"
+
+/// \brief parse a disk given by path[,size[,io_impl[,direct]]], exit if illegal
+///
+inline stxxl::disk_config parseDisk(const std::string & _spec) {
+
+	std::vector<std::string> fields;
+
+	for (size_t beg = 0, end; ; beg = end + 1) {
+
+		end = _spec.find(',', beg);
+
+		fields.push_back(_spec.substr(beg, end - beg));
+
+		if (end == std::string::npos) break;
+	}
+
+	if (fields.size() > 4 || fields[0].empty()) {
+
+		std::cerr << "illegal disk: " << _spec << "\n";
+
+		exit(-1);
+	}
+
+	uint64 size = DISK_DEFAULT_SIZE;
+
+	if (fields.size() > 1 && !fields[1].empty()) size = std::stoull(fields[1]);
+
+	std::string io_impl = fields.size() > 2 ? fields[2] : "syscall";
+
+	if (io_impl != "syscall" && io_impl != "linuxaio" && io_impl != "memory") {
+
+		std::cerr << "io implementation must be syscall, linuxaio or memory.\n";
+
+		exit(-1);
+	}
+
+	std::string direct = fields.size() > 3 ? fields[3] : "try";
+
+	if (direct != "try" && direct != "on" && direct != "off") {
+
+		std::cerr << "direct I/O must be try, on or off.\n";
+
+		exit(-1);
+	}
+
+	bool is_file = (io_impl != "memory");
+
+	stxxl::disk_config disk(fields[0], size * 1024 * 1024, io_impl + (is_file ? " autogrow unlink" : " autogrow"));
+
+	if (is_file) disk.direct = (direct == "on") ? stxxl::disk_config::DIRECT_ON : ((direct == "off") ? stxxl::disk_config::DIRECT_OFF : stxxl::disk_config::DIRECT_TRY);
+
+	return disk;
+}
+
+/// \brief mount the disks given by --disk, or the default one if none
+///
+inline void mountDisks(int argc, char** argv) {
+
+	stxxl::config *cfg = stxxl::config::get_instance();
+
+	bool is_given = false;
+
+	for (int i = 1; i + 1 < argc; ++i) {
+
+		if (std::string(argv[i]) == "--disk") {
+
+			cfg->add_disk(parseDisk(argv[++i]));
+
+			is_given = true;
+		}
+	}
+
+	if (!is_given) cfg->add_disk(parseDisk(DISK_DEFAULT_PATH));
+}
+
+typedef std::vector<stxxl::file_stats_data> file_stats_list_type; ///< statistics kept by stxxl for each opened file
+
+/// \brief take a snapshot of the statistics of the opened files
+///
+inline file_stats_list_type getFileStats() {
+
+	return stxxl::stats::get_instance()->deepcopy_file_stats_data_list();
+}
+
+/// \brief compute the bytes read from and written to each mounted disk since _file_stats_begin
+///
+/// \note A disk is identified by the device id assigned when the block manager opens its file.
+/// Files opened directly (e.g., the input string and the output SA) have the default device id and are not counted.
+inline void getDiskVolumes(const file_stats_list_type & _file_stats_begin, std::vector<uint64> & _read, std::vector<uint64> & _written) {
+
+	stxxl::config *cfg = stxxl::config::get_instance();
+
+	const file_stats_list_type file_stats_end = getFileStats();
+
+	_read.assign(cfg->disks_number(), 0), _written.assign(cfg->disks_number(), 0);
+
+	for (size_t i = 0; i < cfg->disks_number(); ++i) {
+
+		const unsigned int device_id = cfg->disk(i).device_id;
+
+		if (device_id == stxxl::file::DEFAULT_DEVICE_ID) continue; // never opened
+
+		stxxl::int64 read = 0, written = 0;
+
+		for (size_t j = 0; j < file_stats_end.size(); ++j) {
+
+			if (file_stats_end[j].get_device_id() == device_id) read += file_stats_end[j].get_read_bytes(), written += file_stats_end[j].get_write_bytes();
+		}
+
+		for (size_t j = 0; j < _file_stats_begin.size(); ++j) {
+
+			if (_file_stats_begin[j].get_device_id() == device_id) read -= _file_stats_begin[j].get_read_bytes(), written -= _file_stats_begin[j].get_write_bytes();
+		}
+
+		_read[i] = read, _written[i] = written;
+	}
+}
+
+/// \brief report the mounted disks with their volumes and the I/O statistics collected by stxxl since _stats_begin
+///
+/// For several disks, stxxl summarizes the per-disk reads and writes (min, mean, median and max over the disks).
+///
+inline void reportDisks(const stxxl::stats_data & _stats_begin, const file_stats_list_type & _file_stats_begin) {
+
+	stxxl::config *cfg = stxxl::config::get_instance();
+
+	std::vector<uint64> read, written;
+
+	getDiskVolumes(_file_stats_begin, read, written);
+
+	for (size_t i = 0; i < cfg->disks_number(); ++i) {
+
+		const stxxl::disk_config & disk = cfg->disk(i);
+
+		std::cerr << "disk " << i << ": " << disk.path << " (" << disk.io_impl << ", " << disk.size / 1024 / 1024 << " MB), read: " << read[i] / 1024 / 1024 << " MB, written: " << written[i] / 1024 / 1024 << " MB" << std::endl;
+	}
+
+	std::cerr << (stxxl::stats_data(*stxxl::stats::get_instance()) - _stats_begin);
+}
+
+/// \brief add the mounted disks with their volumes since _file_stats_begin as a list of records
+///
+inline void addDiskMetrics(Metrics & _metrics, const file_stats_list_type & _file_stats_begin) {
+
+	stxxl::config *cfg = stxxl::config::get_instance();
+
+	std::vector<uint64> read, written;
+
+	getDiskVolumes(_file_stats_begin, read, written);
+
+	for (size_t i = 0; i < cfg->disks_number(); ++i) {
+
+		const stxxl::disk_config & disk = cfg->disk(i);
+
+		Metrics record;
+
+		record.addString("path", disk.path);
+
+		record.addString("io_impl", disk.io_impl);
+
+		record.addInteger("initial_size", disk.size);
+
+		record.addInteger("read_bytes", read[i]);
+
+		record.addInteger("written_bytes", written[i]);
+
+		_metrics.addRecord("disks", record);
+	}
+}
+
+#endif // _DISKS_H
@@ -0,0 +1,366 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file fp_checker.h
+/// \brief Probabilistic checking of a suffix array by fingerprints and sampled spot checks.
+///
+/// Unlike Checker, no sorter is involved, the text is scanned twice and the SA once, all the scans are sequential.
+/// (1) Fingerprint: SA is a permutation of [0, n) and bucketed by the heading characters of the suffixes
+/// iff the multiset {<sa[i], c_i>} equals the multiset {<j, s[j]>}, where c_i is the character of the bucket covering rank i.
+/// The two multisets are compared by the products of (z - pos - r * (ch + 1)) modulo 2^61 - 1 for random z and r.
+/// Two independent fingerprints are computed, an SA violating the condition passes the test with probability at most (n / 2^61)^2.
+/// (2) Spot checks: for randomly sampled ranks i, the windows of length FP_CHECK_WINDOW starting at sa[i - 1] and sa[i]
+/// are collected in a second scan of the text and compared. A pair whose windows are equal is inconclusive.
+/// The order of the unsampled adjacent suffixes is not verified, an SA passing the check may still be unsorted.
+///////////////////////////////////////////////////////////
+
+#ifndef _FP_CHECKER_H
+#define _FP_CHECKER_H
+
+#include "common.h"
+#include "io.h"
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <iostream>
+
+constexpr uint64 FP_CHECK_PRIME = (uint64(1) << 61) - 1; ///< modulus of the fingerprints
+
+constexpr uint32 FP_CHECK_ROUND = 2; ///< number of independent fingerprints
+
+constexpr uint32 FP_CHECK_WINDOW = 256; ///< number of characters compared for a sampled pair
+
+/// \brief check SA by fingerprints and sampled spot checks
+///
+template<typename alphabet_type, typename offset_type>
+class FingerprintChecker{
+
+private:
+
+	typedef typename ExVector<alphabet_type>::vector alphabet_vector_type;
+
+	typedef typename ExVector<offset_type>::vector offset_vector_type;
+
+	/// \brief a window to be collected from the text
+	///
+	struct Request{
+
+		uint64 pos; ///< starting position
+
+		uint32 idx; ///< 2 * pair_idx for the smaller suffix, 2 * pair_idx + 1 for the larger one
+
+		bool operator<(const Request & _other) const {
+
+			return pos < _other.pos;
+		}
+	};
+
+private:
+
+	std::string m_s_fname;
+
+	std::string m_sa_fname;
+
+	uint64 m_sample_num; ///< number of sampled ranks
+
+	uint64 m_seed; ///< seed for generating the random numbers
+
+	uint64 m_s_len; ///< number of characters in the input string
+
+	std::vector<uint64> m_bkt_size; ///< number of occurrences of each character
+
+	uint64 m_z[FP_CHECK_ROUND]; ///< evaluation points of the fingerprints
+
+	uint64 m_r[FP_CHECK_ROUND]; ///< coefficients for combining <pos, ch>
+
+	std::vector<Request> m_requests; ///< windows to be collected
+
+	std::vector<alphabet_type> m_windows; ///< collected windows, FP_CHECK_WINDOW characters for each request
+
+	std::vector<uint32> m_window_lens; ///< number of characters in each collected window
+
+	uint64 m_verified_num; ///< number of sampled pairs verified
+
+	uint64 m_inconclusive_num; ///< number of sampled pairs with equal windows
+
+public:
+
+	/// \brief ctor
+	///
+	FingerprintChecker(const std::string & _s_fname, const std::string & _sa_fname, const uint64 _sample_num, const uint64 _seed) :
+		m_s_fname(_s_fname), m_sa_fname(_sa_fname), m_sample_num(_sample_num), m_seed(_seed), m_s_len(0), m_verified_num(0), m_inconclusive_num(0) {
+
+		// the windows of the sampled pairs must fit in a quarter of the memory
+		m_sample_num = std::min(m_sample_num, MAX_MEM / 4 / (2 * FP_CHECK_WINDOW * sizeof(alphabet_type)));
+
+		std::mt19937_64 rng(m_seed);
+
+		for (uint32 i = 0; i < FP_CHECK_ROUND; ++i) {
+
+			m_z[i] = rng() % FP_CHECK_PRIME, m_r[i] = rng() % FP_CHECK_PRIME;
+		}
+	}
+
+	/// \brief check
+	///
+	bool run() {
+
+		uint64 s_fp[FP_CHECK_ROUND], sa_fp[FP_CHECK_ROUND];
+
+		scanString(s_fp);
+
+		std::vector<uint64> ranks;
+
+		sampleRanks(ranks);
+
+		if (!scanSA(sa_fp, ranks)) return false;
+
+		for (uint32 i = 0; i < FP_CHECK_ROUND; ++i) {
+
+			if (s_fp[i] != sa_fp[i]) {
+
+				std::cerr << "fingerprints mismatch: not a permutation or not bucketed by the heading characters\n";
+
+				return false;
+			}
+		}
+
+		collectWindows();
+
+		bool is_right = comparePairs();
+
+		std::cerr << "fingerprints match, order checked on sampled pairs only: " << m_requests.size() / 2 << ", verified: " << m_verified_num << ", inconclusive: " << m_inconclusive_num << ", seed: " << m_seed << "\n";
+
+		return is_right;
+	}
+
+private:
+
+	/// \brief compute (_a * _b) % FP_CHECK_PRIME
+	///
+	static uint64 mulmod(const uint64 _a, const uint64 _b) {
+
+		const unsigned __int128 prod = static_cast<unsigned __int128>(_a) * _b;
+
+		uint64 res = (static_cast<uint64>(prod) & FP_CHECK_PRIME) + static_cast<uint64>(prod >> 61);
+
+		return res >= FP_CHECK_PRIME ? res - FP_CHECK_PRIME : res;
+	}
+
+	/// \brief multiply _fp by (z - pos - r * (ch + 1)) for each round
+	///
+	void accumulate(uint64 * _fp, const uint64 _pos, const uint64 _ch) const {
+
+		for (uint32 i = 0; i < FP_CHECK_ROUND; ++i) {
+
+			uint64 term = (_pos < FP_CHECK_PRIME ? _pos : _pos % FP_CHECK_PRIME) + mulmod(m_r[i], _ch + 1);
+
+			if (term >= FP_CHECK_PRIME) term -= FP_CHECK_PRIME;
+
+			_fp[i] = mulmod(_fp[i], m_z[i] >= term ? m_z[i] - term : m_z[i] + FP_CHECK_PRIME - term);
+		}
+	}
+
+	/// \brief scan the input string to count the characters and compute the fingerprints of {<j, s[j]>}
+	///
+	void scanString(uint64 * _fp) {
+
+		std::fill(_fp, _fp + FP_CHECK_ROUND, uint64(1));
+
+		stxxl::syscall_file *s_file = new stxxl::syscall_file(m_s_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+
+		alphabet_vector_type *s = new alphabet_vector_type(s_file);
+
+		m_s_len = s->size();
+
+		typename alphabet_vector_type::const_iterator it = s->begin();
+
+		for (uint64 j = 0; it != s->end(); ++it, ++j) {
+
+			const uint64 ch = *it;
+
+			if (ch >= m_bkt_size.size()) {
+
+				if (ch >= MAX_MEM / 4 / sizeof(uint64)) {
+
+					std::cerr << "character " << ch << " is too large for counting in RAM, check without --fast.\n";
+
+					exit(-1);
+				}
+
+				m_bkt_size.resize(ch + 1, 0);
+			}
+
+			++m_bkt_size[ch];
+
+			accumulate(_fp, j, ch);
+		}
+
+		delete s; s = nullptr;
+
+		delete s_file; s_file = nullptr;
+	}
+
+	/// \brief sample distinct ranks in [1, n) in ascending order
+	///
+	void sampleRanks(std::vector<uint64> & _ranks) {
+
+		if (m_s_len < 2) return;
+
+		std::mt19937_64 rng(m_seed + 1);
+
+		_ranks.reserve(m_sample_num);
+
+		for (uint64 i = 0; i < m_sample_num; ++i) {
+
+			_ranks.push_back(1 + rng() % (m_s_len - 1));
+		}
+
+		std::sort(_ranks.begin(), _ranks.end());
+
+		_ranks.erase(std::unique(_ranks.begin(), _ranks.end()), _ranks.end());
+	}
+
+	/// \brief scan SA to compute the fingerprints of {<sa[i], c_i>} and produce the requests for the sampled pairs
+	///
+	bool scanSA(uint64 * _fp, const std::vector<uint64> & _ranks) {
+
+		std::fill(_fp, _fp + FP_CHECK_ROUND, uint64(1));
+
+		stxxl::syscall_file *sa_file = new stxxl::syscall_file(m_sa_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+
+		offset_vector_type *sa = new offset_vector_type(sa_file);
+
+		if (sa->size() != m_s_len) {
+
+			std::cerr << "sa size does not match s size\n";
+
+			delete sa; sa = nullptr;
+
+			delete sa_file; sa_file = nullptr;
+
+			return false;
+		}
+
+		m_requests.reserve(2 * _ranks.size());
+
+		typename offset_vector_type::const_iterator it = sa->begin();
+
+		uint64 ch = 0, bkt_end = m_bkt_size.empty() ? 0 : m_bkt_size[0];
+
+		uint64 last_pos = 0;
+
+		std::vector<uint64>::const_iterator rank_it = _ranks.begin();
+
+		for (uint64 i = 0; it != sa->end(); ++it, ++i) {
+
+			while (i >= bkt_end) bkt_end += m_bkt_size[++ch];
+
+			const uint64 pos = *it;
+
+			accumulate(_fp, pos, ch);
+
+			if (rank_it != _ranks.end() && *rank_it == i) {
+
+				const uint32 pair_idx = m_requests.size() / 2;
+
+				m_requests.push_back(Request{last_pos, 2 * pair_idx});
+
+				m_requests.push_back(Request{pos, 2 * pair_idx + 1});
+
+				++rank_it;
+			}
+
+			last_pos = pos;
+		}
+
+		delete sa; sa = nullptr;
+
+		delete sa_file; sa_file = nullptr;
+
+		return true;
+	}
+
+	/// \brief scan the input string to collect the windows for the requests
+	///
+	void collectWindows() {
+
+		m_windows.resize(m_requests.size() * FP_CHECK_WINDOW);
+
+		m_window_lens.assign(m_requests.size(), 0);
+
+		if (m_requests.empty()) return;
+
+		std::vector<Request> requests(m_requests);
+
+		std::sort(requests.begin(), requests.end());
+
+		stxxl::syscall_file *s_file = new stxxl::syscall_file(m_s_fname, stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+
+		alphabet_vector_type *s = new alphabet_vector_type(s_file);
+
+		typename alphabet_vector_type::const_iterator it = s->begin() + requests[0].pos;
+
+		std::vector<uint32> active; // requests whose windows cover the current position
+
+		size_t next = 0;
+
+		for (uint64 j = requests[0].pos; it != s->end() && (next < requests.size() || !active.empty()); ++it, ++j) {
+
+			for (; next < requests.size() && requests[next].pos == j; ++next) active.push_back(requests[next].idx);
+
+			const alphabet_type ch = *it;
+
+			size_t k = 0;
+
+			for (size_t l = 0; l < active.size(); ++l) {
+
+				const uint32 idx = active[l];
+
+				m_windows[idx * FP_CHECK_WINDOW + m_window_lens[idx]++] = ch;
+
+				if (m_window_lens[idx] < FP_CHECK_WINDOW) active[k++] = idx;
+			}
+
+			active.resize(k);
+		}
+
+		delete s; s = nullptr;
+
+		delete s_file; s_file = nullptr;
+	}
+
+	/// \brief compare the windows of each sampled pair
+	///
+	/// \note a window shorter than FP_CHECK_WINDOW reaches the end of the string, where the sentinel is smaller than any character
+	bool comparePairs() {
+
+		for (uint32 pair_idx = 0; pair_idx < m_requests.size() / 2; ++pair_idx) {
+
+			const alphabet_type *win1 = &m_windows[2 * pair_idx * FP_CHECK_WINDOW], *win2 = win1 + FP_CHECK_WINDOW;
+
+			const uint32 len1 = m_window_lens[2 * pair_idx], len2 = m_window_lens[2 * pair_idx + 1];
+
+			if (std::lexicographical_compare(win1, win1 + len1, win2, win2 + len2)) {
+
+				++m_verified_num;
+			}
+			else if (len1 == FP_CHECK_WINDOW && len2 == FP_CHECK_WINDOW && std::equal(win1, win1 + len1, win2)) {
+
+				++m_inconclusive_num;
+			}
+			else {
+
+				std::cerr << "suffixes out of order: sa[i - 1] = " << m_requests[2 * pair_idx].pos << ", sa[i] = " << m_requests[2 * pair_idx + 1].pos << "\n";
+
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+#endif // _FP_CHECKER_H
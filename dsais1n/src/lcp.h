@@ -0,0 +1,476 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file lcp.h
+/// \brief Compute the LCP array while the SA is produced.
+///
+/// SA entries are redirected to the builder at the time they are induced by the final merge,
+/// no extra scan of the SA is required for computing the LCP array.
+///////////////////////////////////////////////////////////
+
+#ifndef _LCP_H
+#define _LCP_H
+
+#include "common.h"
+#include "io.h"
+#include "tuple.h"
+#include "tuple_sorter.h"
+#include "sorter.h"
+#include "logger.h"
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+/// \brief compute LCP by the Phi algorithm in external memory
+///
+/// Phi[sa[i]] = sa[i - 1] and PLCP[j] = lcp(j, Phi[j]), LCP[i] = PLCP[sa[i]], where LCP[0] = 0.
+/// PLCP[j] = PLCP[j - 1] - 1 if s[j - 1] = s[Phi[j] - 1] (reducible), i.e., bwt[i] = bwt[i - 1] for j = sa[i],
+/// so the irreducible pairs are found by the preceding characters given with the SA entries, without accessing the input string.
+/// Only the irreducible values are computed by comparing characters, the sum of them is O(n log n).
+///
+/// The irreducible pairs are compared in rounds, each round scans the input string twice:
+/// (1) each pair <j, Phi[j]> matched h characters so far requests the chunks of CHUNK_SIZE characters starting at j + h + k * CHUNK_SIZE, 0 <= k < w,
+/// the requests are sorted by the starting position and filled by a sequential scan;
+/// (2) the filled chunks are sorted by Phi[j] + h + k * CHUNK_SIZE and compared with the input string by another sequential scan.
+/// Each pair also records that it is carried over with h + w * CHUNK_SIZE, the mismatches found in (2) are smaller,
+/// so the first record of j after sorting by <j, value> gives either PLCP[j] or the pair for the next round.
+/// w starts with 1 and doubles each round, thus there are O(log(max lcp)) rounds.
+/// A round scans s twice and sorts O(1 + h / CHUNK_SIZE) requests for each remaining pair, no segment of s is read more than twice.
+/// The irreducible pairs are produced in the order of j, the first round fills their chunks without sorting the requests.
+///
+/// PLCP values are computed in text order and sorted back by rank to produce LCP.
+///
+/// \note The sorters filled by push() take PUSH_MEM, which the final merge leaves out of its heaps.
+/// After the merge, run() gives the sorters and the scan buffer alive at the same time disjoint parts of MAX_MEM.
+template<typename alphabet_type, typename offset_type, typename lcp_offset_type>
+class LCPBuilder{
+
+public:
+
+	static constexpr uint64 PUSH_MEM = MAX_MEM / 4; ///< RAM for the sorters filled during the final merge
+
+private:
+
+	static constexpr uint64 CHUNK_SIZE = 16 / sizeof(alphabet_type); ///< number of characters in a chunk
+
+	static constexpr uint64 SCAN_SIZE = MAX_MEM / 8 / sizeof(alphabet_type) > CHUNK_SIZE ? MAX_MEM / 8 / sizeof(alphabet_type) : CHUNK_SIZE; ///< number of characters in the scan buffer
+
+	typedef Pair<offset_type, offset_type> pair_type; // <sa[i], i>, <j, Phi[j]>, <j, PLCP[j]> or <i, LCP[i]>
+
+	typedef TupleAscCmp1<pair_type> pair_comparator_type;
+
+	typedef MySorter<pair_type, pair_comparator_type> pair_sorter_type;
+
+	typedef Triple<offset_type, offset_type, offset_type> result_type; // <j, PLCP[j], s_len> for a mismatch, <j, h, Phi[j]> for a pair to be carried over
+
+	typedef TupleAscCmp2<result_type> result_comparator_type;
+
+	typedef MySorter<result_type, result_comparator_type> result_sorter_type;
+
+	typedef Triple<offset_type, offset_type, offset_type> request_type; // <j + h + k * CHUNK_SIZE, j, Phi[j] + h + k * CHUNK_SIZE>
+
+	typedef TupleAscCmp2<request_type> request_comparator_type;
+
+	typedef MySorter<request_type, request_comparator_type> request_sorter_type;
+
+	/// \brief a chunk of characters fetched for a request
+	///
+	struct Chunk{
+
+		offset_type first; ///< Phi[j] + h + k * CHUNK_SIZE
+
+		offset_type second; ///< j
+
+		offset_type third; ///< h + k * CHUNK_SIZE
+
+		uint8 m_len; ///< number of characters fetched, less than CHUNK_SIZE at the end of s
+
+		alphabet_type m_ch[CHUNK_SIZE]; ///< characters starting at j + h + k * CHUNK_SIZE
+
+		/// \brief ctor, default
+		///
+		Chunk() {}
+
+		/// \brief ctor
+		///
+		Chunk(const offset_type & _first, const offset_type & _second, const offset_type & _third) : first(_first), second(_second), third(_third), m_len(0) {}
+	}__attribute__((packed));
+
+	typedef TupleAscCmp2<Chunk> chunk_comparator_type;
+
+	typedef MySorter<Chunk, chunk_comparator_type> chunk_sorter_type;
+
+	typedef typename ExVector<lcp_offset_type>::vector lcp_offset_vector_type;
+
+	/// \brief scan the input string from left to right, keeping a window of characters in RAM
+	///
+	struct Scanner{
+
+		FILE *m_file; ///< handler to the input string
+
+		const uint64 m_s_len; ///< number of characters in the input string
+
+		alphabet_type *m_data; ///< payload
+
+		uint64 m_beg_pos; ///< starting position of the window
+
+		uint64 m_end_pos; ///< ending position of the window (exclusive)
+
+		/// \brief ctor
+		///
+		Scanner(FILE *_file, const uint64 _s_len) : m_file(_file), m_s_len(_s_len), m_beg_pos(0), m_end_pos(0) {
+
+			m_data = new alphabet_type[SCAN_SIZE];
+
+			rewind(m_file);
+		}
+
+		/// \brief dtor
+		///
+		~Scanner() {
+
+			delete[] m_data; m_data = nullptr;
+		}
+
+		/// \brief get s[_pos, _pos + _len), _pos must be non-decreasing across the calls and _len no more than CHUNK_SIZE
+		///
+		/// \note the returned pointer is valid until the next call
+		const alphabet_type * fetch(const uint64 _pos, const uint64 _len) {
+
+			assert(_pos >= m_beg_pos && _pos + _len <= m_s_len);
+
+			if (_pos + _len > m_end_pos) { // slide the window, the file is read up to m_end_pos
+
+				uint64 kept_num = 0; // characters in [_pos, m_end_pos) are kept
+
+				if (_pos < m_end_pos) {
+
+					kept_num = m_end_pos - _pos;
+
+					std::memmove(m_data, m_data + (_pos - m_beg_pos), kept_num * sizeof(alphabet_type));
+				}
+				else if (fseek(m_file, _pos * sizeof(alphabet_type), SEEK_SET) != 0) { // skip forward
+
+					error();
+				}
+
+				const uint64 read_num = std::min(SCAN_SIZE - kept_num, m_s_len - _pos - kept_num);
+
+				if (fread(m_data + kept_num, sizeof(alphabet_type), read_num, m_file) != read_num) error();
+
+				m_beg_pos = _pos, m_end_pos = _pos + kept_num + read_num;
+
+#ifdef STATISTICS_COLLECTION
+
+				Logger::addIV(read_num * sizeof(alphabet_type));
+#endif
+			}
+
+			return m_data + (_pos - m_beg_pos);
+		}
+
+		/// \brief report a failed read and exit
+		///
+		void error() const {
+
+			std::cerr << "fail to read the input string\n";
+
+			exit(-1);
+		}
+	};
+
+private:
+
+	const std::string m_s_fname; ///< input string file name
+
+	const std::string m_lcp_fname; ///< output LCP file name
+
+	const uint64 m_s_len; ///< number of characters in the input string (the sentinel excluded)
+
+	pair_sorter_type *m_sa_sorter; ///< sort <sa[i], i> by sa[i]
+
+	pair_sorter_type *m_irreducible_sorter; ///< sort the irreducible <j, Phi[j]> by j
+
+	offset_type m_next_pos; ///< sa[i + 1]
+
+	alphabet_type m_next_ch; ///< bwt[i + 1]
+
+	uint64 m_rank; ///< i
+
+public:
+
+	/// \brief ctor
+	///
+	LCPBuilder(const std::string & _s_fname, const std::string & _lcp_fname, const uint64 _s_len) :
+		m_s_fname(_s_fname), m_lcp_fname(_lcp_fname), m_s_len(_s_len) {
+
+		m_sa_sorter = new pair_sorter_type(PUSH_MEM / 2);
+
+		m_irreducible_sorter = new pair_sorter_type(PUSH_MEM / 2);
+
+		m_rank = m_s_len;
+	}
+
+	/// \brief receive sa[i] and bwt[i] = s[sa[i] - 1], suffixes must be pushed in descending lexicographical order
+	///
+	/// \note sa[i] is the predecessor of sa[i + 1] received last time
+	void push(const offset_type & _pos, const alphabet_type & _pre_ch) {
+
+		--m_rank;
+
+		m_sa_sorter->push(pair_type(_pos, m_rank));
+
+		if (m_rank + 1 < m_s_len) {
+
+			if (static_cast<uint64>(m_next_pos) == 0 || static_cast<uint64>(_pos) == 0 || m_next_ch != _pre_ch) { // irreducible
+
+				m_irreducible_sorter->push(pair_type(m_next_pos, _pos));
+			}
+		}
+
+		m_next_pos = _pos, m_next_ch = _pre_ch;
+	}
+
+	/// \brief compute PLCP in text order, then produce LCP in rank order
+	///
+	void run() {
+
+		assert(m_rank == 0);
+
+		// the leftmost suffix has no predecessor, take the (empty) sentinel suffix instead
+		if (m_s_len != 0) m_irreducible_sorter->push(pair_type(m_next_pos, m_s_len));
+
+		m_sa_sorter->sort(); // release the RAM block
+
+		FILE *s_file = fopen(m_s_fname.c_str(), "rb");
+
+		if (s_file == nullptr) {
+
+			std::cerr << "fail to open " << m_s_fname << "\n";
+
+			exit(-1);
+		}
+
+		pair_sorter_type *plcp_sorter = new pair_sorter_type(MAX_MEM / 4); // irreducible values
+
+		// the first round, fill the first chunk of each irreducible pair in the order of j
+		result_sorter_type *result_sorter = new result_sorter_type(MAX_MEM / 4);
+
+		chunk_sorter_type *chunk_sorter = new chunk_sorter_type(MAX_MEM / 4);
+
+		Scanner *scanner = new Scanner(s_file, m_s_len);
+
+		m_irreducible_sorter->sort();
+
+		for (; !m_irreducible_sorter->empty(); ++(*m_irreducible_sorter)) {
+
+			const uint64 pos = (*(*m_irreducible_sorter)).first, phi = (*(*m_irreducible_sorter)).second;
+
+			if (phi == m_s_len) { // compared with the sentinel suffix
+
+				result_sorter->push(result_type(pos, 0, m_s_len));
+
+				continue;
+			}
+
+			result_sorter->push(result_type(pos, (m_s_len < CHUNK_SIZE ? m_s_len : CHUNK_SIZE), phi));
+
+			fillChunk(scanner, chunk_sorter, pos, pos, phi);
+		}
+
+		delete m_irreducible_sorter; m_irreducible_sorter = nullptr;
+
+		delete scanner; scanner = nullptr;
+
+		compareChunks(s_file, chunk_sorter, result_sorter);
+
+		// the other rounds, pairs carried over request the next chunks
+		for (uint64 chunk_num = 2; result_sorter != nullptr; chunk_num = std::min(chunk_num * 2, static_cast<uint64>(m_s_len / CHUNK_SIZE + 1))) {
+
+			result_sorter_type *next_result_sorter = nullptr; // created on demand
+
+			request_sorter_type *request_sorter = nullptr;
+
+			result_sorter->sort();
+
+			while (!result_sorter->empty()) {
+
+				const result_type result = *(*result_sorter);
+
+				while (!result_sorter->empty() && (*(*result_sorter)).first == result.first) ++(*result_sorter); // the first record of j decides
+
+				if (static_cast<uint64>(result.third) == m_s_len) { // mismatch
+
+					plcp_sorter->push(pair_type(result.first, result.second));
+
+					continue;
+				}
+
+				if (request_sorter == nullptr) {
+
+					next_result_sorter = new result_sorter_type(MAX_MEM / 4);
+
+					request_sorter = new request_sorter_type(MAX_MEM / 4);
+				}
+
+				uint64 h = result.second;
+
+				for (uint64 k = 0; k < chunk_num; ++k, h += CHUNK_SIZE) {
+
+					const uint64 pos = static_cast<uint64>(result.first) + h, phi = static_cast<uint64>(result.third) + h;
+
+					if (pos >= m_s_len || phi >= m_s_len) { // reach the end of s
+
+						next_result_sorter->push(result_type(result.first, h, m_s_len));
+
+						break;
+					}
+
+					request_sorter->push(request_type(pos, result.first, phi));
+				}
+
+				if (h == static_cast<uint64>(result.second) + chunk_num * CHUNK_SIZE) { // all the chunks are requested
+
+					next_result_sorter->push(result_type(result.first, std::min(h, m_s_len), result.third));
+				}
+			}
+
+			delete result_sorter; result_sorter = next_result_sorter;
+
+			if (request_sorter == nullptr) break; // all the pairs are finished
+
+			// fill the chunks by scanning in the order of j + h
+			chunk_sorter = new chunk_sorter_type(MAX_MEM / 4);
+
+			scanner = new Scanner(s_file, m_s_len);
+
+			request_sorter->sort();
+
+			for (; !request_sorter->empty(); ++(*request_sorter)) {
+
+				const request_type & request = *(*request_sorter);
+
+				fillChunk(scanner, chunk_sorter, request.first, request.second, request.third);
+			}
+
+			delete request_sorter; request_sorter = nullptr;
+
+			delete scanner; scanner = nullptr;
+
+			compareChunks(s_file, chunk_sorter, result_sorter);
+		}
+
+		fclose(s_file);
+
+		// compute PLCP in text order, sort by rank
+		pair_sorter_type *lcp_sorter = new pair_sorter_type(MAX_MEM / 2);
+
+		plcp_sorter->sort();
+
+		for (uint64 pos = 0, h = 0; pos < m_s_len; ++pos) {
+
+			if (!plcp_sorter->empty() && static_cast<uint64>((*(*plcp_sorter)).first) == pos) { // irreducible
+
+				h = (*(*plcp_sorter)).second;
+
+				++(*plcp_sorter);
+			}
+			else { // reducible
+
+				assert(h > 0);
+
+				--h;
+			}
+
+			assert(static_cast<uint64>((*(*m_sa_sorter)).first) == pos);
+
+			lcp_sorter->push(pair_type((*(*m_sa_sorter)).second, h));
+
+			++(*m_sa_sorter);
+		}
+
+		delete plcp_sorter; plcp_sorter = nullptr;
+
+		delete m_sa_sorter; m_sa_sorter = nullptr;
+
+		// produce LCP
+		lcp_sorter->sort();
+
+		stxxl::syscall_file *lcp_file = new stxxl::syscall_file(m_lcp_fname, stxxl::syscall_file::CREAT | stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+
+		lcp_offset_vector_type *lcp = new lcp_offset_vector_type(lcp_file);
+
+		lcp->resize(m_s_len);
+
+		typename lcp_offset_vector_type::bufwriter_type lcp_writer(*lcp);
+
+		for (; !lcp_sorter->empty(); ++(*lcp_sorter)) {
+
+			lcp_writer << lcp_offset_type(static_cast<uint64>((*(*lcp_sorter)).second));
+		}
+
+		lcp_writer.finish();
+
+#ifdef STATISTICS_COLLECTION
+
+		Logger::addOV(m_s_len * sizeof(lcp_offset_type)); // write lcp (stxxl)
+#endif
+
+		// clear
+		delete lcp_sorter; lcp_sorter = nullptr;
+
+		delete lcp; lcp = nullptr;
+
+		delete lcp_file; lcp_file = nullptr;
+	}
+
+private:
+
+	/// \brief fetch the chunk starting at _pos for the pair <_j, Phi[_j]>, compared with the one starting at _phi_pos later
+	///
+	/// \note _pos must be non-decreasing across the calls
+	void fillChunk(Scanner *_scanner, chunk_sorter_type *_chunk_sorter, const uint64 _pos, const uint64 _j, const uint64 _phi_pos) {
+
+		Chunk chunk(_phi_pos, _j, _pos - _j);
+
+		chunk.m_len = (m_s_len - _pos < CHUNK_SIZE) ? m_s_len - _pos : CHUNK_SIZE;
+
+		std::memcpy(chunk.m_ch, _scanner->fetch(_pos, chunk.m_len), chunk.m_len * sizeof(alphabet_type));
+
+		_chunk_sorter->push(chunk);
+	}
+
+	/// \brief compare the chunks by scanning in the order of Phi[j] + h, record the mismatches in _result_sorter
+	///
+	/// \note _chunk_sorter is deleted
+	void compareChunks(FILE *_s_file, chunk_sorter_type *& _chunk_sorter, result_sorter_type *_result_sorter) {
+
+		Scanner *scanner = new Scanner(_s_file, m_s_len);
+
+		_chunk_sorter->sort();
+
+		for (; !_chunk_sorter->empty(); ++(*_chunk_sorter)) {
+
+			const Chunk & chunk = *(*_chunk_sorter);
+
+			const uint64 phi_pos = chunk.first, len = std::min(static_cast<uint64>(chunk.m_len), m_s_len - phi_pos);
+
+			const alphabet_type *phi_ch = scanner->fetch(phi_pos, len);
+
+			uint64 offset = 0;
+
+			while (offset < len && chunk.m_ch[offset] == phi_ch[offset]) ++offset;
+
+			if (offset < CHUNK_SIZE) _result_sorter->push(result_type(chunk.second, static_cast<uint64>(chunk.third) + offset, m_s_len));
+		}
+
+		delete _chunk_sorter; _chunk_sorter = nullptr;
+
+		delete scanner; scanner = nullptr;
+	}
+};
+
+#endif // _LCP_H
@@ -4,6 +4,9 @@
 /// \file logger.h
 /// \brief Record measurements (PDU + IOV). 
 ///
+/// Besides the global measurements, wall time, CPU time, IOV and PDU are recorded for each phase at each recursion level.
+/// Measurements of a phase include those of its nested phases.
+/// If enabled, hardware performance counters are also recorded for each phase.
 ///
 /// \author Yi Wu
 /// \date 2017.7
@@ -14,7 +17,61 @@
 #define _LOGGER_H
 
 #include "common.h"
+#include "metrics.h"
+#include "perf.h"
 
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <algorithm>
+
+/// \brief measurements of a phase at a recursion level, accumulated over calls
+///
+struct PhaseInfo{
+
+	std::string m_name; ///< phase name
+
+	uint32 m_level; ///< recursion level
+
+	uint32 m_calls; ///< number of calls
+
+	double m_wall; ///< wall time (in seconds)
+
+	double m_cpu; ///< CPU time (in seconds)
+
+	double m_iv; ///< input volume
+
+	double m_ov; ///< output volume
+
+	double m_max_pdu; ///< maximum peak disk use during the phase
+
+	double m_perf[PERF_EVENT_NUM]; ///< hardware event counts
+
+	/// \brief ctor
+	///
+	PhaseInfo(const std::string & _name, const uint32 _level) : m_name(_name), m_level(_level), m_calls(0), m_wall(0), m_cpu(0), m_iv(0), m_ov(0), m_max_pdu(0) {
+
+		for (uint32 i = 0; i < PERF_EVENT_NUM; ++i) m_perf[i] = 0;
+	}
+};
+
+/// \brief start point of a running phase
+///
+struct PhaseStart{
+
+	uint32 m_idx; ///< index of the phase in the phase list
+
+	std::chrono::steady_clock::time_point m_wall; ///< wall clock at start
+
+	std::clock_t m_cpu; ///< CPU clock at start
+
+	double m_iv; ///< input volume at start
+
+	double m_ov; ///< output volume at start
+
+	double m_perf[PERF_EVENT_NUM]; ///< hardware event counts at start
+};
 
 /// \brief a logger for recording pdu and iov
 ///
@@ -28,6 +85,16 @@ private:
 	static double cur_iv; ///< current input volume
 
 	static double cur_ov; ///< current output volume
+
+	static std::vector<PhaseInfo> phases; ///< phases in the order of their first calls
+
+	static std::vector<PhaseStart> running_phases; ///< stack of running phases
+
+	static const std::chrono::steady_clock::time_point start_time; ///< wall clock at program start
+
+	static std::vector<uint64> block_nums; ///< number of blocks at each recursion level
+
+	static PerfCounters *perf_counters; ///< hardware performance counters, nullptr if disabled
 public:
 
 	/// \brief increase pdu
@@ -37,6 +104,13 @@ public:
 		cur_pdu += _delta;
 
 		if (cur_pdu >= max_pdu) max_pdu = cur_pdu;
+
+		for (size_t i = 0; i < running_phases.size(); ++i) {
+
+			PhaseInfo & phase = phases[running_phases[i].m_idx];
+
+			if (cur_pdu > phase.m_max_pdu) phase.m_max_pdu = cur_pdu;
+		}
 	}
 
 	/// \brief decrease pdu
@@ -59,6 +133,84 @@ public:
 		cur_ov += _delta;
 	}
 
+	/// \brief record the number of blocks partitioned at the given recursion level
+	///
+	static void recordBlockNum(const uint32 _level, const uint64 _block_num) {
+
+		if (block_nums.size() <= _level) block_nums.resize(_level + 1, 0);
+
+		block_nums[_level] = _block_num;
+	}
+
+	/// \brief enable hardware performance counters for phases started afterwards
+	///
+	/// \note no-op if no counter is available
+	static void enablePerfCounters() {
+
+		if (perf_counters != nullptr) return;
+
+		perf_counters = new PerfCounters();
+
+		if (!perf_counters->any_available()) {
+
+			std::cerr << "hardware performance counters are unavailable.\n";
+
+			delete perf_counters; perf_counters = nullptr;
+		}
+	}
+
+	/// \brief start a phase at the given recursion level
+	///
+	/// \note phases must be ended in the reverse order of starting
+	static void startPhase(const std::string & _name, const uint32 _level) {
+
+		uint32 idx = 0;
+
+		while (idx < phases.size() && (phases[idx].m_name != _name || phases[idx].m_level != _level)) ++idx;
+
+		if (idx == phases.size()) phases.push_back(PhaseInfo(_name, _level));
+
+		phases[idx].m_max_pdu = std::max(phases[idx].m_max_pdu, cur_pdu);
+
+		PhaseStart start;
+
+		start.m_idx = idx, start.m_wall = std::chrono::steady_clock::now(), start.m_cpu = std::clock(), start.m_iv = cur_iv, start.m_ov = cur_ov;
+
+		if (perf_counters != nullptr) perf_counters->read_all(start.m_perf);
+
+		running_phases.push_back(start);
+	}
+
+	/// \brief end the most recently started phase
+	///
+	static void endPhase() {
+
+		const PhaseStart & start = running_phases.back();
+
+		PhaseInfo & phase = phases[start.m_idx];
+
+		if (perf_counters != nullptr) {
+
+			double perf[PERF_EVENT_NUM];
+
+			perf_counters->read_all(perf);
+
+			for (uint32 i = 0; i < PERF_EVENT_NUM; ++i) phase.m_perf[i] += perf[i] - start.m_perf[i];
+		}
+
+		++phase.m_calls;
+
+		phase.m_wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - start.m_wall).count();
+
+		phase.m_cpu += static_cast<double>(std::clock() - start.m_cpu) / CLOCKS_PER_SEC;
+
+		phase.m_iv += cur_iv - start.m_iv;
+
+		phase.m_ov += cur_ov - start.m_ov;
+
+		running_phases.pop_back();
+	}
+
 	static void report(const uint64 _corpora_size) {
 
 		std::cerr << "--------------------------------------------------------------\n";
@@ -78,6 +230,141 @@ public:
 		std::cerr << "write volume: " << cur_ov / K_1024 / 1024 << " GB" <<std::endl;
 
 		std::cerr << "write volume (per char)" << cur_ov / _corpora_size << std::endl;
+
+		std::cerr << "elapsed time: " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() << " s" << std::endl;
+
+		std::cerr << "CPU time: " << static_cast<double>(std::clock()) / CLOCKS_PER_SEC << " s" << std::endl;
+
+		std::cerr << "Phase breakdown (nested phases included, volumes in MB):\n";
+
+		std::cerr << "level\tcalls\twall(s)\tcpu(s)\tread\twrite\tpeak disk\tphase\n";
+
+		for (size_t i = 0; i < phases.size(); ++i) {
+
+			const PhaseInfo & phase = phases[i];
+
+			std::cerr << phase.m_level << "\t" << phase.m_calls << "\t" << phase.m_wall << "\t" << phase.m_cpu << "\t"
+				<< phase.m_iv / K_1024 << "\t" << phase.m_ov / K_1024 << "\t" << phase.m_max_pdu / K_1024 << "\t\t"
+				<< std::string(2 * phase.m_level, ' ') << phase.m_name << "\n";
+		}
+
+		if (perf_counters == nullptr) return;
+
+		std::cerr << "Phase hardware counters (in millions, - if unavailable):\n";
+
+		std::cerr << "level";
+
+		for (uint32 j = 0; j < PERF_EVENT_NUM; ++j) std::cerr << "\t" << PerfCounters::name(j);
+
+		std::cerr << "\tIPC\tphase\n";
+
+		for (size_t i = 0; i < phases.size(); ++i) {
+
+			const PhaseInfo & phase = phases[i];
+
+			std::cerr << phase.m_level;
+
+			for (uint32 j = 0; j < PERF_EVENT_NUM; ++j) {
+
+				if (perf_counters->is_available(j)) std::cerr << "\t" << phase.m_perf[j] / 1e6; else std::cerr << "\t-";
+			}
+
+			if (perf_counters->is_available(PERF_CYCLES) && perf_counters->is_available(PERF_INSTRUCTIONS) && phase.m_perf[PERF_CYCLES] > 0) {
+
+				std::cerr << "\t" << phase.m_perf[PERF_INSTRUCTIONS] / phase.m_perf[PERF_CYCLES];
+			}
+			else {
+
+				std::cerr << "\t-";
+			}
+
+			std::cerr << "\t" << std::string(2 * phase.m_level, ' ') << phase.m_name << "\n";
+		}
+	}
+
+	/// \brief add the measurements to a metrics document
+	///
+	static void fillMetrics(Metrics & _metrics, const uint64 _corpora_size) {
+
+		_metrics.addReal("elapsed_time", std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+
+		_metrics.addReal("cpu_time", static_cast<double>(std::clock()) / CLOCKS_PER_SEC);
+
+		_metrics.addReal("read_volume", cur_iv);
+
+		_metrics.addReal("read_volume_per_char", cur_iv / _corpora_size);
+
+		_metrics.addReal("write_volume", cur_ov);
+
+		_metrics.addReal("write_volume_per_char", cur_ov / _corpora_size);
+
+		_metrics.addReal("peak_disk_use", max_pdu);
+
+		_metrics.addReal("peak_disk_use_per_char", max_pdu / _corpora_size);
+
+		_metrics.addInteger("recursion_depth", block_nums.size());
+
+		_metrics.addInteger("block_count", block_nums.empty() ? 0 : block_nums[0]);
+
+		for (size_t i = 0; i < block_nums.size(); ++i) {
+
+			Metrics level;
+
+			level.addInteger("level", i);
+
+			level.addInteger("block_count", block_nums[i]);
+
+			_metrics.addRecord("levels", level);
+		}
+
+		for (size_t i = 0; i < phases.size(); ++i) {
+
+			Metrics phase;
+
+			phase.addString("name", phases[i].m_name);
+
+			phase.addInteger("level", phases[i].m_level);
+
+			phase.addInteger("calls", phases[i].m_calls);
+
+			phase.addReal("wall_time", phases[i].m_wall);
+
+			phase.addReal("cpu_time", phases[i].m_cpu);
+
+			phase.addReal("read_volume", phases[i].m_iv);
+
+			phase.addReal("write_volume", phases[i].m_ov);
+
+			phase.addReal("peak_disk_use", phases[i].m_max_pdu);
+
+			for (uint32 j = 0; perf_counters != nullptr && j < PERF_EVENT_NUM; ++j) {
+
+				if (perf_counters->is_available(j)) phase.addReal(PerfCounters::name(j), phases[i].m_perf[j]);
+			}
+
+			_metrics.addRecord("phases", phase);
+		}
+	}
+};
+
+/// \brief record a phase from construction to destruction
+///
+class LoggerPhase{
+
+public:
+
+	/// \brief ctor, start the phase
+	///
+	LoggerPhase(const std::string & _name, const uint32 _level) {
+
+		Logger::startPhase(_name, _level);
+	}
+
+	/// \brief dtor, end the phase
+	///
+	~LoggerPhase() {
+
+		Logger::endPhase();
 	}
 };
 
@@ -90,4 +377,14 @@ double Logger::cur_iv = 0;
 
 double Logger::cur_ov = 0;
 
+std::vector<PhaseInfo> Logger::phases;
+
+std::vector<PhaseStart> Logger::running_phases;
+
+const std::chrono::steady_clock::time_point Logger::start_time = std::chrono::steady_clock::now();
+
+std::vector<uint64> Logger::block_nums;
+
+PerfCounters *Logger::perf_counters = nullptr;
+
 #endif
@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file metrics.h
+/// \brief Machine-readable measurements of a run.
+///
+/// A document consists of named scalar fields and named lists of records.
+/// It is written as a JSON object, or as a two-line CSV table (header + values) if the file name ends with ".csv".
+/// In the CSV table, a field of the i-th record in a list is named as list[i].field.
+///////////////////////////////////////////////////////////
+
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cmath>
+
+/// \brief a document of measurements
+///
+class Metrics{
+
+private:
+
+	std::vector<std::string> m_keys; ///< names of scalar fields
+
+	std::vector<std::string> m_values; ///< values of scalar fields (text)
+
+	std::vector<bool> m_is_string; ///< true if a value is quoted as a string
+
+	std::vector<std::string> m_list_keys; ///< names of lists
+
+	std::vector<std::vector<Metrics> > m_lists; ///< records in lists
+
+public:
+
+	/// \brief add an integer field
+	///
+	void addInteger(const std::string & _key, const uint64 _value) {
+
+		m_keys.push_back(_key), m_values.push_back(std::to_string(_value)), m_is_string.push_back(false);
+	}
+
+	/// \brief add a real field
+	///
+	void addReal(const std::string & _key, const double _value) {
+
+		std::ostringstream oss;
+
+		if (std::isfinite(_value)) oss << std::setprecision(10) << _value; else oss << "null"; // e.g., per char measurements of an empty input
+
+		m_keys.push_back(_key), m_values.push_back(oss.str()), m_is_string.push_back(false);
+	}
+
+	/// \brief add a boolean field
+	///
+	void addBool(const std::string & _key, const bool _value) {
+
+		m_keys.push_back(_key), m_values.push_back(_value ? "true" : "false"), m_is_string.push_back(false);
+	}
+
+	/// \brief add a string field
+	///
+	void addString(const std::string & _key, const std::string & _value) {
+
+		m_keys.push_back(_key), m_values.push_back(_value), m_is_string.push_back(true);
+	}
+
+	/// \brief append a record to a list, the list is created if not exists
+	///
+	void addRecord(const std::string & _list_key, const Metrics & _record) {
+
+		size_t idx = 0;
+
+		while (idx < m_list_keys.size() && m_list_keys[idx] != _list_key) ++idx;
+
+		if (idx == m_list_keys.size()) m_list_keys.push_back(_list_key), m_lists.push_back(std::vector<Metrics>());
+
+		m_lists[idx].push_back(_record);
+	}
+
+	/// \brief write the document, exit if the file cannot be created
+	///
+	void write(const std::string & _fname) const {
+
+		std::ofstream fout(_fname.c_str());
+
+		if (!fout) {
+
+			std::cerr << "fail to create " << _fname << "\n";
+
+			exit(-1);
+		}
+
+		const bool is_csv = _fname.size() >= 4 && _fname.compare(_fname.size() - 4, 4, ".csv") == 0;
+
+		if (is_csv) {
+
+			std::vector<std::string> keys, values;
+
+			flatten("", keys, values);
+
+			for (size_t i = 0; i < keys.size(); ++i) fout << (i == 0 ? "" : ",") << keys[i];
+
+			fout << "\n";
+
+			for (size_t i = 0; i < values.size(); ++i) fout << (i == 0 ? "" : ",") << values[i];
+
+			fout << "\n";
+		}
+		else {
+
+			writeJSON(fout, 0);
+
+			fout << "\n";
+		}
+	}
+
+private:
+
+	/// \brief quote a string for JSON
+	///
+	static std::string encodeJSON(const std::string & _value) {
+
+		std::string encoded = "\"";
+
+		for (size_t i = 0; i < _value.size(); ++i) {
+
+			const char ch = _value[i];
+
+			if (ch == '"' || ch == '\\') {
+
+				encoded += '\\', encoded += ch;
+			}
+			else if (static_cast<unsigned char>(ch) < 0x20) {
+
+				char buf[8];
+
+				snprintf(buf, sizeof(buf), "\\u%04x", ch);
+
+				encoded += buf;
+			}
+			else {
+
+				encoded += ch;
+			}
+		}
+
+		return encoded + "\"";
+	}
+
+	/// \brief quote a string for CSV if it contains separators or quotes
+	///
+	static std::string encodeCSV(const std::string & _value) {
+
+		if (_value.find_first_of(",\"\n") == std::string::npos) return _value;
+
+		std::string encoded = "\"";
+
+		for (size_t i = 0; i < _value.size(); ++i) {
+
+			if (_value[i] == '"') encoded += '"';
+
+			encoded += _value[i];
+		}
+
+		return encoded + "\"";
+	}
+
+	/// \brief write the document as a JSON object
+	///
+	void writeJSON(std::ostream & _out, const uint32 _indent) const {
+
+		const std::string pad(_indent + 1, '\t');
+
+		_out << "{";
+
+		for (size_t i = 0; i < m_keys.size(); ++i) {
+
+			_out << (i == 0 ? "\n" : ",\n") << pad << "\"" << m_keys[i] << "\": " << (m_is_string[i] ? encodeJSON(m_values[i]) : m_values[i]);
+		}
+
+		for (size_t i = 0; i < m_list_keys.size(); ++i) {
+
+			_out << ((i == 0 && m_keys.empty()) ? "\n" : ",\n") << pad << "\"" << m_list_keys[i] << "\": [";
+
+			for (size_t j = 0; j < m_lists[i].size(); ++j) {
+
+				_out << (j == 0 ? "\n" : ",\n") << pad << "\t";
+
+				m_lists[i][j].writeJSON(_out, _indent + 2);
+			}
+
+			_out << "\n" << pad << "]";
+		}
+
+		_out << "\n" << std::string(_indent, '\t') << "}";
+	}
+
+	/// \brief collect fields for a CSV table
+	///
+	void flatten(const std::string & _prefix, std::vector<std::string> & _keys, std::vector<std::string> & _values) const {
+
+		for (size_t i = 0; i < m_keys.size(); ++i) {
+
+			_keys.push_back(_prefix + m_keys[i]);
+
+			_values.push_back(m_is_string[i] ? encodeCSV(m_values[i]) : m_values[i]);
+		}
+
+		for (size_t i = 0; i < m_list_keys.size(); ++i) {
+
+			for (size_t j = 0; j < m_lists[i].size(); ++j) {
+
+				m_lists[i][j].flatten(_prefix + m_list_keys[i] + "[" + std::to_string(j) + "].", _keys, _values);
+			}
+		}
+	}
+};
+
+/// \brief add I/O volume and peak disk use collected by stxxl since _stats_begin
+///
+inline void addStxxlMetrics(Metrics & _metrics, const stxxl::stats_data & _stats_begin, const uint64 _corpora_size) {
+
+	stxxl::stats_data stats_delta = stxxl::stats_data(*stxxl::stats::get_instance()) - _stats_begin;
+
+	const double read_volume = stats_delta.get_read_volume(), write_volume = stats_delta.get_written_volume();
+
+	const double pdu = stxxl::block_manager::get_instance()->get_maximum_allocation();
+
+	_metrics.addReal("read_volume", read_volume);
+
+	_metrics.addReal("read_volume_per_char", read_volume / _corpora_size);
+
+	_metrics.addReal("write_volume", write_volume);
+
+	_metrics.addReal("write_volume_per_char", write_volume / _corpora_size);
+
+	_metrics.addReal("peak_disk_use", pdu);
+
+	_metrics.addReal("peak_disk_use_per_char", pdu / _corpora_size);
+}
+
+#endif // _METRICS_H
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file microbench.cpp
+/// \brief Run the microbenchmarks of the external-memory primitives.
+///
+/// Usage:
+/// microbench vector [n] (default n: 64M elements)
+/// microbench sorter [n] (default n: 64M elements)
+/// microbench pq [--mem bytes] trace_path... (traces recorded by a builder compiled with -DPQ_TRACE_COLLECTION)
+///////////////////////////////////////////////////////////
+
+#include "microbench.h"
+
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+
+	if (argc < 2) {
+
+		std::cerr << "one param required: vector | sorter | pq.\n";
+
+		std::cerr << "vector [n]: write and scan n elements forward, reverse and read-remove for each buffer size.\n";
+
+		std::cerr << "sorter [n]: sort n elements for each block capacity.\n";
+
+		std::cerr << "pq [--mem bytes] trace_path...: replay priority queue traces, with the recorded memory unless --mem is given.\n";
+
+		exit(-1);
+	}
+
+	const std::string bench(argv[1]);
+
+	if (bench == "vector" || bench == "sorter") {
+
+		const uint64 n = (argc > 2) ? std::stoull(argv[2]) : 64 * K_1024;
+
+		printBenchHeader();
+
+		if (bench == "vector") benchMyVector(n); else benchMySorter(n);
+	}
+	else if (bench == "pq") {
+
+		uint64 avail_mem = 0;
+
+		printBenchHeader();
+
+		for (int i = 2; i < argc; ++i) {
+
+			std::string param(argv[i]);
+
+			if (param == "--mem" && i + 1 < argc) {
+
+				avail_mem = std::stoull(argv[++i]);
+			}
+			else {
+
+				benchPQTrace(param, avail_mem);
+			}
+		}
+	}
+	else {
+
+		std::cerr << "unknown benchmark: " << bench << "\n";
+
+		exit(-1);
+	}
+
+	return 0;
+}
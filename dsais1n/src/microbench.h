@@ -0,0 +1,367 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file microbench.h
+/// \brief Microbenchmarks for the external-memory primitives.
+///
+/// Measure MyVector scans across buffer sizes, MySorter across block capacities and the priority queues
+/// on traces recorded by the builder (see trace.h), each in isolation from the rest of the construction.
+/// Throughput is reported in elements/s and in bytes/s, where bytes are elements times the element size.
+///
+/// \note temporary files are created in the working directory, they are likely to stay in the page cache for small inputs.
+///////////////////////////////////////////////////////////
+
+#ifndef _MICROBENCH_H
+#define _MICROBENCH_H
+
+#include "common.h"
+#include "tuple.h"
+#include "tuple_sorter.h"
+#include "vector.h"
+#include "sorter.h"
+#include "pq_sub.h"
+#include "pq_suf.h"
+#include "trace.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <iostream>
+
+constexpr uint64 TRACE_CHUNK = 4 * K_1024; ///< number of trace records loaded into RAM before replaying them
+
+static volatile uint64 bench_sink = 0; ///< keep replayed results alive
+
+/// \brief wall clock for a measurement
+///
+class BenchTimer{
+
+private:
+
+	std::chrono::steady_clock::time_point m_start; ///< start point
+
+public:
+
+	/// \brief ctor, start timing
+	///
+	BenchTimer() : m_start(std::chrono::steady_clock::now()) {}
+
+	/// \brief elapsed time since start (in seconds)
+	///
+	double elapsed() const {
+
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+	}
+};
+
+/// \brief print the header of the result table
+///
+void printBenchHeader() {
+
+	printf("%-16s %-28s %14s %10s %16s %12s\n", "benchmark", "parameters", "elements", "time(s)", "elements/s", "MB/s");
+}
+
+/// \brief print a row of the result table
+///
+void printBenchResult(const std::string & _name, const std::string & _params, const uint64 _elements, const uint64 _bytes, const double _seconds) {
+
+	const double elements_per_sec = (_seconds > 0) ? _elements / _seconds : 0, bytes_per_sec = (_seconds > 0) ? _bytes / _seconds : 0;
+
+	printf("%-16s %-28s %14llu %10.3f %16.0f %12.2f\n", _name.c_str(), _params.c_str(), static_cast<unsigned long long>(_elements), _seconds, elements_per_sec, bytes_per_sec / K_1024);
+
+	fflush(stdout);
+}
+
+/// \brief 64-bit mixer for generating keys
+///
+inline uint64 benchHash(uint64 _x) {
+
+	_x = (_x ^ (_x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+
+	_x = (_x ^ (_x >> 27)) * 0x94D049BB133111EBULL;
+
+	return _x ^ (_x >> 31);
+}
+
+/// \brief write, then scan forward, reverse and read-remove a MyVector of _n elements for each buffer size
+///
+void benchMyVector(const uint64 _n) {
+
+	typedef uint40 element_type; // offset_type at the top level
+
+	typedef MyVector<element_type> vector_type;
+
+	const uint64 buf_sizes[] = {64 * 1024, 256 * 1024, K_1024, VEC_BUF_RAM, 8 * K_1024};
+
+	const uint64 bytes = _n * sizeof(element_type);
+
+	for (uint64 buf_size : buf_sizes) {
+
+		const std::string params = "buf=" + std::to_string(buf_size / 1024) + "K";
+
+		uint64 checksum = 0;
+
+		vector_type *vec = new vector_type(buf_size);
+
+		{
+			BenchTimer timer;
+
+			for (uint64 i = 0; i < _n; ++i) vec->push_back(element_type(i)); // the last buffer is flushed by start_read()
+
+			printBenchResult("vector_write", params, _n, bytes, timer.elapsed());
+		}
+
+		{
+			BenchTimer timer;
+
+			vec->start_read();
+
+			while (!vec->is_eof()) checksum += vec->get(), vec->next();
+
+			printBenchResult("vector_forward", params, _n, bytes, timer.elapsed());
+		}
+
+		{
+			BenchTimer timer;
+
+			vec->start_read_reverse();
+
+			while (!vec->is_eof()) checksum += vec->get_reverse(), vec->next_reverse();
+
+			printBenchResult("vector_reverse", params, _n, bytes, timer.elapsed());
+		}
+
+		{
+			BenchTimer timer;
+
+			vec->start_read();
+
+			while (!vec->is_eof()) checksum += vec->get(), vec->next_remove();
+
+			printBenchResult("vector_remove", params, _n, bytes, timer.elapsed());
+		}
+
+		delete vec; vec = nullptr;
+
+		if (checksum != 3 * (_n * (_n - 1) / 2)) {
+
+			std::cerr << "vector benchmark read wrong elements.\n";
+
+			exit(-1);
+		}
+	}
+}
+
+/// \brief sort _n pseudo-random pairs by MySorter for each block capacity
+///
+/// The number of runs is the number of blocks formed, i.e., _n * element size / capacity rounded up.
+void benchMySorter(const uint64 _n) {
+
+	typedef Pair<uint40, uint40> element_type; // (key, idx), any two are different
+
+	typedef TupleAscCmp2<element_type> comparator_type;
+
+	typedef MySorter<element_type, comparator_type> sorter_type;
+
+	const uint64 capacities[] = {K_1024, 4 * K_1024, 16 * K_1024, 64 * K_1024, 256 * K_1024};
+
+	const uint64 bytes = _n * sizeof(element_type);
+
+	for (uint64 capacity : capacities) {
+
+		const uint64 block_capacity = capacity / sizeof(element_type);
+
+		const std::string params = "block=" + std::to_string(capacity / K_1024) + "M runs=" + std::to_string((_n + block_capacity - 1) / block_capacity);
+
+		sorter_type *sorter = new sorter_type(capacity);
+
+		BenchTimer timer;
+
+		for (uint64 i = 0; i < _n; ++i) sorter->push(element_type(benchHash(i) & 0xFFFFFFFFFFULL, i));
+
+		const double push_time = timer.elapsed();
+
+		sorter->sort();
+
+		element_type pre = element_type::min_value();
+
+		uint64 cnt = 0;
+
+		while (!sorter->empty()) {
+
+			const element_type & cur = *(*sorter);
+
+			if (cnt > 0 && !comparator_type()(pre, cur)) {
+
+				std::cerr << "sorter benchmark produced an unsorted sequence.\n";
+
+				exit(-1);
+			}
+
+			pre = cur, ++cnt, ++(*sorter);
+		}
+
+		const double total_time = timer.elapsed();
+
+		delete sorter; sorter = nullptr;
+
+		printBenchResult("sorter_runs", params, _n, bytes, push_time);
+
+		printBenchResult("sorter_merge", params, _n, bytes, total_time - push_time);
+
+		printBenchResult("sorter_total", params, _n, bytes, total_time);
+	}
+}
+
+/// \brief replay bucket operations on PQL_SUB
+///
+template<typename alphabet_type, typename offset_type, typename pq2_element_type, typename pq2_comparator_type>
+void replayBucketOp(PQL_SUB<alphabet_type, offset_type, pq2_element_type, pq2_comparator_type> & _pq, const uint8 _op, uint64 & _checksum) {
+
+	if (_op == PQ_OP_IS_DIFF) _checksum += _pq.is_diff(); else _pq.flush();
+}
+
+/// \brief replay bucket operations on PQS_SUB
+///
+template<typename alphabet_type, typename offset_type, typename pq2_element_type, typename pq2_comparator_type>
+void replayBucketOp(PQS_SUB<alphabet_type, offset_type, pq2_element_type, pq2_comparator_type> & _pq, const uint8 _op, uint64 & _checksum) {
+
+	if (_op == PQ_OP_IS_DIFF) _checksum += _pq.is_diff(); else _pq.flush();
+}
+
+/// \brief PQL_SUF and PQS_SUF have no bucket operations
+///
+template<typename pq_type>
+void replayBucketOp(pq_type &, const uint8, uint64 &) {}
+
+/// \brief replay a trace on a priority queue, trace records are loaded chunk by chunk and only the replay is timed
+///
+template<typename pq_type, typename pq2_element_type>
+void replayPQ(PQTraceReader & _trace, const uint64 _avail_mem, const std::string & _params) {
+
+	typedef decltype(pq2_element_type::first) first_type;
+
+	typedef decltype(pq2_element_type::second) second_type;
+
+	typedef decltype(pq2_element_type::third) third_type;
+
+	pq_type *pq = new pq_type(_avail_mem);
+
+	std::vector<uint8> ops;
+
+	std::vector<pq2_element_type> values;
+
+	uint64 op_num = 0, push_num = 0, checksum = 0;
+
+	double replay_time = 0;
+
+	uint8 op;
+
+	uint64 value[3];
+
+	bool more = true;
+
+	while (more) {
+
+		ops.clear(), values.clear();
+
+		while (ops.size() < TRACE_CHUNK && (more = _trace.next(op, value))) {
+
+			ops.push_back(op);
+
+			if (op == PQ_OP_PUSH) values.push_back(pq2_element_type(static_cast<first_type>(value[0]), static_cast<second_type>(value[1]), static_cast<third_type>(value[2])));
+		}
+
+		BenchTimer timer;
+
+		for (uint64 i = 0, j = 0; i < ops.size(); ++i) {
+
+			switch (ops[i]) {
+
+			case PQ_OP_PUSH: pq->push(values[j++]); break;
+
+			case PQ_OP_TOP: checksum += pq->top().second; break;
+
+			case PQ_OP_POP: pq->pop(); break;
+
+			default: replayBucketOp(*pq, ops[i], checksum); break;
+			}
+		}
+
+		replay_time += timer.elapsed();
+
+		op_num += ops.size(), push_num += values.size();
+	}
+
+	delete pq; pq = nullptr;
+
+	printBenchResult(pqTraceKindName(_trace.m_kind), _params + " ops=" + std::to_string(op_num), push_num, push_num * sizeof(pq2_element_type), replay_time);
+
+	bench_sink = checksum;
+}
+
+/// \brief dispatch on the kind of the traced priority queue
+///
+template<typename alphabet_type, typename offset_type>
+void replayPQTrace(PQTraceReader & _trace, const uint64 _avail_mem, const std::string & _params) {
+
+	typedef Triple<alphabet_type, offset_type, offset_type> triple_type; // same as the induction in builder.h
+
+	switch (_trace.m_kind) {
+
+	case PQ_TRACE_L_SUB: replayPQ<PQL_SUB<alphabet_type, offset_type, triple_type, TupleDscCmp3<triple_type> >, triple_type>(_trace, _avail_mem, _params); break;
+
+	case PQ_TRACE_S_SUB: replayPQ<PQS_SUB<alphabet_type, offset_type, triple_type, TupleAscCmp3<triple_type> >, triple_type>(_trace, _avail_mem, _params); break;
+
+	case PQ_TRACE_L_SUF: replayPQ<PQL_SUF<alphabet_type, offset_type, triple_type, TupleDscCmp2<triple_type> >, triple_type>(_trace, _avail_mem, _params); break;
+
+	default: replayPQ<PQS_SUF<alphabet_type, offset_type, triple_type, TupleAscCmp2<triple_type> >, triple_type>(_trace, _avail_mem, _params); break;
+	}
+}
+
+/// \brief dispatch on the alphabet width, which is 1, 2 or 4 at the top level and the offset width in recursions
+///
+template<typename offset_type>
+void replayPQTrace(PQTraceReader & _trace, const uint64 _avail_mem, const std::string & _params) {
+
+	if (_trace.m_alphabet_width == sizeof(uint8)) replayPQTrace<uint8, offset_type>(_trace, _avail_mem, _params);
+	else if (_trace.m_alphabet_width == sizeof(uint16)) replayPQTrace<uint16, offset_type>(_trace, _avail_mem, _params);
+	else if (_trace.m_alphabet_width == sizeof(uint32)) replayPQTrace<uint32, offset_type>(_trace, _avail_mem, _params);
+	else if (_trace.m_alphabet_width == sizeof(offset_type)) replayPQTrace<offset_type, offset_type>(_trace, _avail_mem, _params);
+	else {
+
+		std::cerr << "unsupported alphabet width in the trace: " << static_cast<uint32>(_trace.m_alphabet_width) << "\n";
+
+		exit(-1);
+	}
+}
+
+/// \brief replay a trace file, _avail_mem = 0 for the memory recorded in the trace
+///
+void benchPQTrace(const std::string & _fname, const uint64 _avail_mem) {
+
+	PQTraceReader trace(_fname);
+
+	const uint64 avail_mem = (_avail_mem == 0) ? trace.m_avail_mem : _avail_mem;
+
+	const std::string params = "mem=" + std::to_string(avail_mem / K_1024) + "M";
+
+	switch (trace.m_offset_width) {
+
+	case sizeof(uint32): replayPQTrace<uint32>(trace, avail_mem, params); break;
+
+	case sizeof(uint40): replayPQTrace<uint40>(trace, avail_mem, params); break;
+
+	case sizeof(uint64): replayPQTrace<uint64>(trace, avail_mem, params); break;
+
+	default:
+
+		std::cerr << "unsupported offset width in the trace: " << static_cast<uint32>(trace.m_offset_width) << "\n";
+
+		exit(-1);
+	}
+}
+
+#endif // _MICROBENCH_H
@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file perf.h
+/// \brief Hardware performance counters of the running process.
+///
+/// Counters are opened by perf_event_open for user-space events of the calling thread and its children.
+/// A counter not supported by the hardware or disallowed by the kernel (e.g., perf_event_paranoid) is skipped,
+/// all the counters are unavailable on systems other than Linux.
+///////////////////////////////////////////////////////////
+
+#ifndef _PERF_H
+#define _PERF_H
+
+#include "common.h"
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// \brief events to be counted
+///
+enum PerfEvent{
+
+	PERF_CYCLES, ///< CPU cycles
+
+	PERF_INSTRUCTIONS, ///< retired instructions
+
+	PERF_LLC_MISSES, ///< last-level cache read misses
+
+	PERF_BRANCH_MISSES, ///< mispredicted branches
+
+	PERF_DTLB_MISSES, ///< data TLB read misses
+
+	PERF_EVENT_NUM
+};
+
+/// \brief a set of counters, one for each event
+///
+class PerfCounters{
+
+private:
+
+	int m_fds[PERF_EVENT_NUM]; ///< file descriptors, -1 if unavailable
+
+public:
+
+	/// \brief ctor, open the counters
+	///
+	PerfCounters() {
+
+		for (uint32 i = 0; i < PERF_EVENT_NUM; ++i) m_fds[i] = openCounter(i);
+	}
+
+	/// \brief dtor, close the counters
+	///
+	~PerfCounters() {
+
+#ifdef __linux__
+
+		for (uint32 i = 0; i < PERF_EVENT_NUM; ++i) {
+
+			if (m_fds[i] != -1) close(m_fds[i]);
+		}
+#endif
+	}
+
+	/// \brief check if the counter for the given event is available
+	///
+	bool is_available(const uint32 _event) const {
+
+		return m_fds[_event] != -1;
+	}
+
+	/// \brief check if any counter is available
+	///
+	bool any_available() const {
+
+		for (uint32 i = 0; i < PERF_EVENT_NUM; ++i) {
+
+			if (m_fds[i] != -1) return true;
+		}
+
+		return false;
+	}
+
+	/// \brief read the counters, 0 for unavailable ones
+	///
+	/// \note values are scaled if the kernel multiplexes the counters
+	void read_all(double * _values) const {
+
+		for (uint32 i = 0; i < PERF_EVENT_NUM; ++i) {
+
+			_values[i] = 0;
+
+#ifdef __linux__
+
+			if (m_fds[i] == -1) continue;
+
+			uint64_t data[3]; // value, time enabled, time running
+
+			if (read(m_fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) continue;
+
+			_values[i] = static_cast<double>(data[0]) * data[1] / data[2];
+#endif
+		}
+	}
+
+	/// \brief name of the given event
+	///
+	static const char * name(const uint32 _event) {
+
+		static const char * names[PERF_EVENT_NUM] = {"cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"};
+
+		return names[_event];
+	}
+
+private:
+
+	/// \brief open a counter for the given event
+	///
+	/// \return file descriptor, -1 if failed
+	static int openCounter(const uint32 _event) {
+
+#ifdef __linux__
+
+		perf_event_attr attr;
+
+		memset(&attr, 0, sizeof(attr));
+
+		attr.size = sizeof(attr);
+
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		attr.exclude_kernel = 1, attr.exclude_hv = 1, attr.inherit = 1;
+
+		switch (_event) {
+
+		case PERF_CYCLES: attr.type = PERF_TYPE_HARDWARE, attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+
+		case PERF_INSTRUCTIONS: attr.type = PERF_TYPE_HARDWARE, attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+
+		case PERF_LLC_MISSES: attr.type = PERF_TYPE_HW_CACHE, attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16); break;
+
+		case PERF_BRANCH_MISSES: attr.type = PERF_TYPE_HARDWARE, attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+
+		default: attr.type = PERF_TYPE_HW_CACHE, attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16); break;
+		}
+
+		return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0)); // this process, any CPU, no group
+#else
+
+		return -1;
+#endif
+	}
+};
+
+#endif // _PERF_H
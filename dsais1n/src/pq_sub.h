@@ -12,6 +12,7 @@
 #define _PQ_SUB_H
 
 #include "vector.h"
+#include "trace.h"
 
 /// \brief a priority queue for sorting L-type substrs.
 ///
@@ -67,6 +68,11 @@ private:
 
 	bool m_flag;
 
+#ifdef PQ_TRACE_COLLECTION
+
+	PQTraceWriter *m_trace; ///< trace of the operations
+#endif
+
 public:
 
 	/// \brief ctor
@@ -91,6 +97,11 @@ public:
 		m_pre_suc_name = std::numeric_limits<offset_type>::max(); // assumed to be max initially
 
 		m_flag = false;
+
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace = new PQTraceWriter(PQ_TRACE_L_SUB, sizeof(alphabet_type), sizeof(offset_type), _avail_mem);
+#endif
 	}
 
 	/// \brief dtor
@@ -102,6 +113,11 @@ public:
 		delete m_heap2; m_heap2 = nullptr;
 
 		delete m_heap3; m_heap3 = nullptr;
+
+#ifdef PQ_TRACE_COLLECTION
+
+		delete m_trace; m_trace = nullptr;
+#endif
 	}
 
 	/// \brief check if PQL_SUB is empty
@@ -118,6 +134,11 @@ public:
 	/// \note check if non-empty before calling the function. In this case, m_heap1 or m_heap2 must be non-empty
 	pql_element_type top() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_TOP);
+#endif
+
 		 if (!m_heap1->empty()) {
 
 			if (!m_heap2->empty()) {
@@ -179,6 +200,11 @@ public:
 	///
 	bool is_diff() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_IS_DIFF);
+#endif
+
 		if (m_pre_block_idx == m_cur_block_idx) { // from the same block
 
 			if (m_cur_block_idx == std::numeric_limits<uint32>::max()) { // both from m_heap2
@@ -208,6 +234,11 @@ public:
 	///
 	void pop() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_POP);
+#endif
+
 		if (m_cur_block_idx == std::numeric_limits<uint32>::max()) { // pop from m_heap2
 
 			m_pre_block_idx = m_cur_block_idx, m_pre_suc_name = m_cur_suc_name, m_pre_ch = m_cur_ch, m_heap2->pop();
@@ -286,6 +317,11 @@ public:
 	///
 	void push(const pq2_element_type & _value) {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record_push(_value.first, _value.second, _value.third);
+#endif
+
 		if (m_heap3->size() == m_pq2_capacity) { // 
 
 			flush_heap();
@@ -300,6 +336,11 @@ public:
 	///
 	void flush() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_FLUSH);
+#endif
+
 		if (m_flag == true) {
 
 			flush_heap();
@@ -376,6 +417,11 @@ private:
 
 	bool m_flag;
 
+#ifdef PQ_TRACE_COLLECTION
+
+	PQTraceWriter *m_trace; ///< trace of the operations
+#endif
+
 public:
 
 	/// \brief ctor
@@ -400,6 +446,11 @@ public:
 		m_pre_suc_name = 0;					
 
 		m_flag = false;
+
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace = new PQTraceWriter(PQ_TRACE_S_SUB, sizeof(alphabet_type), sizeof(offset_type), _avail_mem);
+#endif
 	}	
 
 	/// \brief dtor
@@ -410,6 +461,11 @@ public:
 		delete m_heap2; m_heap2 = nullptr;
 
 		delete m_heap3; m_heap3 = nullptr;
+
+#ifdef PQ_TRACE_COLLECTION
+
+		delete m_trace; m_trace = nullptr;
+#endif
 	}
 
 	/// \brief check if empty
@@ -423,6 +479,11 @@ public:
 	/// \note check if non-empty before calling the function
 	pqs_element_type top() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_TOP);
+#endif
+
 		if (!m_heap1->empty()) {
 
 			if (!m_heap2->empty()) {
@@ -483,6 +544,11 @@ public:
 	///
 	bool is_diff() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_IS_DIFF);
+#endif
+
 		if (m_pre_block_idx == m_cur_block_idx) { // same block or heap2
 
 			if (m_cur_block_idx == std::numeric_limits<uint32>::max()) { // from heap2
@@ -512,6 +578,11 @@ public:
 	/// \note execute top() before calling the function
 	void pop() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_POP);
+#endif
+
 		if (m_cur_block_idx == std::numeric_limits<uint32>::max()) {
 
 			m_pre_block_idx = m_cur_block_idx, m_pre_suc_name = m_cur_suc_name, m_pre_ch = m_cur_ch, m_heap2->pop();
@@ -591,6 +662,11 @@ public:
 	///
 	void push(const pq2_element_type & _value) {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record_push(_value.first, _value.second, _value.third);
+#endif
+
 		if (m_heap3->size() == m_pq2_capacity) {
 	
 			flush_heap();	
@@ -605,6 +681,11 @@ public:
 	///
 	void flush() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_FLUSH);
+#endif
+
 		if (m_flag == true) {
 
 			flush_heap();
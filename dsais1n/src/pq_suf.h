@@ -14,6 +14,7 @@
 #define _PQ_SUF_H
 
 #include "vector.h"
+#include "trace.h"
 
 /// \brief A priority queue for sorting L-type suffixes.
 ///
@@ -49,6 +50,11 @@ private:
 
 	uint32 m_cur_block_idx;	
 
+#ifdef PQ_TRACE_COLLECTION
+
+	PQTraceWriter *m_trace; ///< trace of the operations
+#endif
+
 public:
 
 	/// \brief ctor 
@@ -62,6 +68,11 @@ public:
 		m_pq2_capacity = _avail_mem / sizeof(pq2_element_type);
 
 		m_blocks.clear();
+
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace = new PQTraceWriter(PQ_TRACE_L_SUF, sizeof(alphabet_type), sizeof(offset_type), _avail_mem);
+#endif
 	}
 
 	/// \brief dtor
@@ -71,6 +82,11 @@ public:
 		delete m_heap1; m_heap1 = nullptr;
 
 		delete m_heap2; m_heap2 = nullptr;
+
+#ifdef PQ_TRACE_COLLECTION
+
+		delete m_trace; m_trace = nullptr;
+#endif
 	}
 
 	/// \brief check if PQL_SUF is empty
@@ -87,6 +103,11 @@ public:
 	/// \note check if non-empty before calling the function
 	pql_element_type top() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_TOP);
+#endif
+
 		if (!m_heap1->empty()) {
 
 			if (!m_heap2->empty()) {
@@ -124,6 +145,11 @@ public:
 	///
 	void pop() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_POP);
+#endif
+
 		if (m_cur_block_idx == std::numeric_limits<uint32>::max()) { // pop from heap2
 
 			m_heap2->pop();		
@@ -144,6 +170,11 @@ public:
 	///
 	void push(const pq2_element_type & _value) {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record_push(_value.first, _value.second, _value.third);
+#endif
+
 		m_heap2->push(_value);
 
 		if (m_heap2->size() == m_pq2_capacity) {
@@ -200,6 +231,11 @@ private:
 
 	uint32 m_cur_block_idx;	
 
+#ifdef PQ_TRACE_COLLECTION
+
+	PQTraceWriter *m_trace; ///< trace of the operations
+#endif
+
 public:
 
 	/// \brief ctor 
@@ -213,6 +249,11 @@ public:
 		m_pq2_capacity = _avail_mem / sizeof(pq2_element_type);
 
 		m_blocks.clear();
+
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace = new PQTraceWriter(PQ_TRACE_S_SUF, sizeof(alphabet_type), sizeof(offset_type), _avail_mem);
+#endif
 	}
 
 	/// \brief dtor
@@ -222,6 +263,11 @@ public:
 		delete m_heap1; m_heap1 = nullptr;
 
 		delete m_heap2; m_heap2 = nullptr;
+
+#ifdef PQ_TRACE_COLLECTION
+
+		delete m_trace; m_trace = nullptr;
+#endif
 	}
 
 	/// \brief check if empty
@@ -237,6 +283,11 @@ public:
 	/// \note check if non-empty before calling the function
 	pqs_element_type top() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_TOP);
+#endif
+
 		if (!m_heap1->empty()) {
 
 			if (!m_heap2->empty()) {
@@ -274,6 +325,11 @@ public:
 	/// \note call top() before executing the function
 	void pop() {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record(PQ_OP_POP);
+#endif
+
 		if (m_cur_block_idx == std::numeric_limits<uint32>::max()) { // pop from heap2
 		
 			m_heap2->pop();
@@ -294,6 +350,11 @@ public:
 	///
 	void push(const pq2_element_type & _value) {
 
+#ifdef PQ_TRACE_COLLECTION
+
+		m_trace->record_push(_value.first, _value.second, _value.third);
+#endif
+
 		m_heap2->push(_value);
 
 		if (m_heap2->size() == m_pq2_capacity) {
@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file sampler.h
+/// \brief Produce sampled SA and ISA samples while the SA is produced.
+///
+/// SA entries are redirected to the sampler at the time they are induced by the final merge,
+/// so the samples for FM-index locate queries are obtained without keeping the full SA.
+///////////////////////////////////////////////////////////
+
+#ifndef _SAMPLER_H
+#define _SAMPLER_H
+
+#include "common.h"
+#include "io.h"
+#include "tuple.h"
+#include "tuple_sorter.h"
+#include "sorter.h"
+#include "writer.h"
+#include "logger.h"
+
+#include <string>
+#include <cstdio>
+#include <cassert>
+
+/// \brief sampling mode
+///
+enum SampleMode{
+
+	SAMPLE_BY_RANK, ///< keep sa[i] for i % rate == 0
+
+	SAMPLE_BY_TEXT ///< keep sa[i] for sa[i] % rate == 0, mark the sampled ranks in a bit vector
+};
+
+/// \brief sample SA by rank or by text position, sample ISA by text position
+///
+/// For a string of n characters, each output contains (n + rate - 1) / rate entries:
+/// (1) sampled SA: entries in rank order;
+/// (2) ISA samples: isa[j * rate] for j = 0, 1, ..., in text order;
+/// (3) bit vector (SAMPLE_BY_TEXT only): n bits, bit i (LSB first) is set if sa[i] is sampled.
+///
+/// \note The ISA sorter takes ISA_MEM, which the final merge leaves out of its heaps.
+template<typename offset_type, typename sa_offset_type>
+class SASampler{
+
+public:
+
+	static constexpr uint64 ISA_MEM = MAX_MEM / 8; ///< RAM for the ISA sorter, which receives one entry in every rate
+
+private:
+
+	typedef typename ExVector<sa_offset_type>::vector sa_offset_vector_type;
+
+	typedef Pair<offset_type, offset_type> pair_type; // <sa[i] / rate, i>
+
+	typedef TupleAscCmp1<pair_type> pair_comparator_type;
+
+	typedef MySorter<pair_type, pair_comparator_type> pair_sorter_type;
+
+private:
+
+	const uint64 m_s_len; ///< number of characters in the input string (the sentinel excluded)
+
+	const uint64 m_rate; ///< sampling rate
+
+	const SampleMode m_mode; ///< sampling mode
+
+	const uint64 m_sample_num; ///< number of samples
+
+	const std::string m_isa_fname; ///< fname for ISA samples, empty if not required
+
+	MyReverseWriter<sa_offset_type> *m_ssa_writer; ///< writer for sampled SA
+
+	MyReverseWriter<uint8> *m_bv_writer; ///< writer for marking sampled ranks (SAMPLE_BY_TEXT only)
+
+	uint8 m_bv_byte; ///< bits not yet written to the bit vector
+
+	pair_sorter_type *m_isa_sorter; ///< sort <sa[i] / rate, i> by sa[i], nullptr if not required
+
+	uint64 m_rank; ///< i
+
+public:
+
+	/// \brief ctor
+	///
+	/// \note leave _ssa_fname or _isa_fname empty to disable the corresponding output
+	SASampler(const uint64 _s_len, const uint64 _rate, const SampleMode _mode, const std::string & _ssa_fname, const std::string & _isa_fname) :
+		m_s_len(_s_len), m_rate(_rate), m_mode(_mode), m_sample_num((_s_len + _rate - 1) / _rate), m_isa_fname(_isa_fname) {
+
+		m_ssa_writer = nullptr, m_bv_writer = nullptr, m_bv_byte = 0;
+
+		if (!_ssa_fname.empty()) {
+
+			m_ssa_writer = new MyReverseWriter<sa_offset_type>(_ssa_fname, m_sample_num);
+
+			if (m_mode == SAMPLE_BY_TEXT) {
+
+				m_bv_writer = new MyReverseWriter<uint8>(_ssa_fname + ".bv", (m_s_len + 7) / 8);
+			}
+		}
+
+		m_isa_sorter = m_isa_fname.empty() ? nullptr : new pair_sorter_type(ISA_MEM);
+
+		m_rank = m_s_len;
+	}
+
+	/// \brief dtor
+	///
+	~SASampler() {
+
+		delete m_ssa_writer; m_ssa_writer = nullptr;
+
+		delete m_bv_writer; m_bv_writer = nullptr;
+
+		delete m_isa_sorter; m_isa_sorter = nullptr;
+	}
+
+	/// \brief get the RAM taken while receiving suffixes
+	///
+	uint64 mem_usage() const {
+
+		uint64 mem = 0;
+
+		if (m_ssa_writer != nullptr) mem += VEC_BUF_RAM;
+
+		if (m_bv_writer != nullptr) mem += VEC_BUF_RAM;
+
+		if (m_isa_sorter != nullptr) mem += ISA_MEM;
+
+		return mem;
+	}
+
+	/// \brief receive sa[i], suffixes must be pushed in descending lexicographical order
+	///
+	void push(const offset_type & _pos) {
+
+		--m_rank;
+
+		const bool is_text_sampled = (static_cast<uint64>(_pos) % m_rate == 0);
+
+		if (m_ssa_writer != nullptr) {
+
+			if (m_mode == SAMPLE_BY_RANK) {
+
+				if (m_rank % m_rate == 0) m_ssa_writer->push(sa_offset_type(static_cast<uint64>(_pos)));
+			}
+			else {
+
+				if (is_text_sampled) m_ssa_writer->push(sa_offset_type(static_cast<uint64>(_pos))), m_bv_byte |= (1 << (m_rank % 8));
+
+				if (m_rank % 8 == 0) m_bv_writer->push(m_bv_byte), m_bv_byte = 0;
+			}
+		}
+
+		if (m_isa_sorter != nullptr && is_text_sampled) {
+
+			m_isa_sorter->push(pair_type(static_cast<uint64>(_pos) / m_rate, m_rank));
+		}
+	}
+
+	/// \brief finish sampling, write ISA samples in text order
+	///
+	void finish() {
+
+		assert(m_rank == 0);
+
+		if (m_ssa_writer != nullptr) {
+
+			m_ssa_writer->finish();
+
+			delete m_ssa_writer; m_ssa_writer = nullptr;
+		}
+
+		if (m_bv_writer != nullptr) {
+
+			m_bv_writer->finish();
+
+			delete m_bv_writer; m_bv_writer = nullptr;
+		}
+
+		if (m_isa_sorter != nullptr) {
+
+			m_isa_sorter->sort();
+
+			stxxl::syscall_file *isa_file = new stxxl::syscall_file(m_isa_fname, stxxl::syscall_file::CREAT | stxxl::syscall_file::RDWR | stxxl::syscall_file::DIRECT);
+
+			sa_offset_vector_type *isa = new sa_offset_vector_type(isa_file);
+
+			isa->resize(m_sample_num);
+
+			typename sa_offset_vector_type::bufwriter_type isa_writer(*isa);
+
+			for (; !m_isa_sorter->empty(); ++(*m_isa_sorter)) {
+
+				isa_writer << sa_offset_type(static_cast<uint64>((*(*m_isa_sorter)).second));
+			}
+
+			isa_writer.finish();
+
+#ifdef STATISTICS_COLLECTION
+
+			Logger::addOV(m_sample_num * sizeof(sa_offset_type)); // write isa samples (stxxl)
+#endif
+
+			delete isa; isa = nullptr;
+
+			delete isa_file; isa_file = nullptr;
+
+			delete m_isa_sorter; m_isa_sorter = nullptr;
+		}
+	}
+};
+
+#endif // _SAMPLER_H
@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file sink.h
+/// \brief Receive the final suffixes from the top-level merge.
+///
+/// The top-level mergeSortedSuffixGlobal induces suffixes in descending order.
+/// Instead of materializing a reversed SA, each suffix is redirected to a sink producing the outputs.
+///////////////////////////////////////////////////////////
+
+#ifndef _SINK_H
+#define _SINK_H
+
+#include "common.h"
+#include "writer.h"
+#include "lcp.h"
+#include "sampler.h"
+
+#include <string>
+
+/// \brief files produced by DSAIS, an empty file name disables the corresponding output
+///
+struct OutputInfo{
+
+	std::string m_sa_fname; ///< fname for suffix array
+
+	std::string m_lcp_fname; ///< fname for LCP array, using the same width as suffix array
+
+	std::string m_bwt_fname; ///< fname for BWT, including the sentinel (represented by 0)
+
+	std::string m_ssa_fname; ///< fname for sampled SA
+
+	std::string m_isa_fname; ///< fname for ISA samples
+
+	uint64 m_sample_rate; ///< sampling rate for sampled SA and ISA samples
+
+	SampleMode m_sample_mode; ///< sample SA by rank or by text position
+
+	/// \brief ctor
+	///
+	OutputInfo() : m_sample_rate(32), m_sample_mode(SAMPLE_BY_TEXT) {}
+};
+
+/// \brief interface for receiving the final suffixes
+///
+template<typename alphabet_type, typename offset_type>
+class SuffixSink{
+
+public:
+
+	/// \brief check if the preceding characters are required
+	///
+	virtual bool is_bwt_required() const = 0;
+
+	/// \brief get the RAM taken by the sink while receiving suffixes, the final merge leaves it out
+	///
+	virtual uint64 mem_usage() const = 0;
+
+	/// \brief receive a suffix and its preceding character (0 if not required)
+	///
+	/// \note suffixes are received in descending order, the sentinel suffix comes last
+	virtual void push(const offset_type & _pos, const alphabet_type & _pre_ch) = 0;
+
+	/// \brief dtor
+	///
+	virtual ~SuffixSink() {}
+};
+
+/// \brief produce the outputs specified by OutputInfo
+///
+template<typename alphabet_type, typename offset_type, typename sa_offset_type>
+class DSAISSink : public SuffixSink<alphabet_type, offset_type>{
+
+private:
+
+	const uint64 m_s_len; ///< number of characters in the input string (the sentinel excluded)
+
+	MyReverseWriter<sa_offset_type> *m_sa_writer; ///< writer for SA
+
+	MyReverseWriter<alphabet_type> *m_bwt_writer; ///< writer for BWT
+
+	LCPBuilder<alphabet_type, offset_type, sa_offset_type> *m_lcp_builder; ///< builder for LCP
+
+	SASampler<offset_type, sa_offset_type> *m_sampler; ///< sampler for sampled SA and ISA samples
+
+public:
+
+	/// \brief ctor
+	///
+	DSAISSink(const std::string & _s_fname, const OutputInfo & _output_info, const uint64 _s_len) : m_s_len(_s_len) {
+
+		m_sa_writer = nullptr, m_bwt_writer = nullptr, m_lcp_builder = nullptr, m_sampler = nullptr;
+
+		if (!_output_info.m_sa_fname.empty()) {
+
+			m_sa_writer = new MyReverseWriter<sa_offset_type>(_output_info.m_sa_fname, m_s_len);
+		}
+
+		if (!_output_info.m_bwt_fname.empty()) {
+
+			m_bwt_writer = new MyReverseWriter<alphabet_type>(_output_info.m_bwt_fname, m_s_len + 1);
+		}
+
+		if (!_output_info.m_lcp_fname.empty()) {
+
+			m_lcp_builder = new LCPBuilder<alphabet_type, offset_type, sa_offset_type>(_s_fname, _output_info.m_lcp_fname, m_s_len);
+		}
+
+		if (!_output_info.m_ssa_fname.empty() || !_output_info.m_isa_fname.empty()) {
+
+			m_sampler = new SASampler<offset_type, sa_offset_type>(m_s_len, _output_info.m_sample_rate, _output_info.m_sample_mode,
+				_output_info.m_ssa_fname, _output_info.m_isa_fname);
+		}
+	}
+
+	/// \brief dtor
+	///
+	~DSAISSink() {
+
+		delete m_sa_writer; m_sa_writer = nullptr;
+
+		delete m_bwt_writer; m_bwt_writer = nullptr;
+
+		delete m_lcp_builder; m_lcp_builder = nullptr;
+
+		delete m_sampler; m_sampler = nullptr;
+	}
+
+	/// \brief check if the preceding characters are required
+	///
+	/// \note the LCP builder finds the irreducible pairs by the preceding characters
+	bool is_bwt_required() const {
+
+		return m_bwt_writer != nullptr || m_lcp_builder != nullptr;
+	}
+
+	/// \brief get the RAM taken by the sink while receiving suffixes
+	///
+	uint64 mem_usage() const {
+
+		uint64 mem = 0;
+
+		if (m_sa_writer != nullptr) mem += VEC_BUF_RAM;
+
+		if (m_bwt_writer != nullptr) mem += VEC_BUF_RAM;
+
+		if (m_lcp_builder != nullptr) mem += LCPBuilder<alphabet_type, offset_type, sa_offset_type>::PUSH_MEM;
+
+		if (m_sampler != nullptr) mem += m_sampler->mem_usage();
+
+		return mem;
+	}
+
+	/// \brief receive a suffix and its preceding character
+	///
+	void push(const offset_type & _pos, const alphabet_type & _pre_ch) {
+
+		if (m_bwt_writer != nullptr) m_bwt_writer->push(_pre_ch);
+
+		if (static_cast<uint64>(_pos) == m_s_len) return; // the sentinel is excluded from SA
+
+		if (m_sa_writer != nullptr) m_sa_writer->push(sa_offset_type(static_cast<uint64>(_pos)));
+
+		if (m_lcp_builder != nullptr) m_lcp_builder->push(_pos, _pre_ch);
+
+		if (m_sampler != nullptr) m_sampler->push(_pos);
+	}
+
+	/// \brief finish the outputs
+	///
+	void finish() {
+
+		if (m_sa_writer != nullptr) m_sa_writer->finish();
+
+		if (m_bwt_writer != nullptr) m_bwt_writer->finish();
+
+		if (m_sampler != nullptr) m_sampler->finish();
+
+		if (m_lcp_builder != nullptr) m_lcp_builder->run();
+	}
+};
+
+#endif // _SINK_H
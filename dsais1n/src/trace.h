@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University,
+/// All rights reserved
+/// \file trace.h
+/// \brief Record and read the operation traces of the priority queues used in the induction.
+///
+/// If PQ_TRACE_COLLECTION is defined (e.g., compile the builder with -DPQ_TRACE_COLLECTION),
+/// each PQL_SUB, PQS_SUB, PQL_SUF and PQS_SUF instance writes its operations to pq_trace_<kind>_<idx>.dat,
+/// which can be replayed by microbench to measure a priority queue in isolation.
+///
+/// A trace consists of a header (kind, alphabet width, offset width, available memory) and a sequence of records.
+/// A record is an operation code, followed by the three components of the pushed element for a push operation.
+///////////////////////////////////////////////////////////
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include "common.h"
+
+#include <cstdio>
+#include <string>
+#include <iostream>
+
+/// \brief kinds of the traced priority queues
+///
+enum PQTraceKind{
+
+	PQ_TRACE_L_SUB, ///< PQL_SUB
+
+	PQ_TRACE_S_SUB, ///< PQS_SUB
+
+	PQ_TRACE_L_SUF, ///< PQL_SUF
+
+	PQ_TRACE_S_SUF, ///< PQS_SUF
+
+	PQ_TRACE_KIND_NUM
+};
+
+/// \brief operations on a priority queue
+///
+enum PQTraceOp{
+
+	PQ_OP_PUSH,
+
+	PQ_OP_TOP,
+
+	PQ_OP_POP,
+
+	PQ_OP_IS_DIFF,
+
+	PQ_OP_FLUSH
+};
+
+/// \brief name of the given kind
+///
+inline const char * pqTraceKindName(const uint32 _kind) {
+
+	static const char * names[PQ_TRACE_KIND_NUM] = {"pql_sub", "pqs_sub", "pql_suf", "pqs_suf"};
+
+	return names[_kind];
+}
+
+/// \brief write the trace of a priority queue instance
+///
+class PQTraceWriter{
+
+private:
+
+	FILE *m_file; ///< trace file
+
+public:
+
+	/// \brief ctor, create a trace file and write the header
+	///
+	PQTraceWriter(const uint8 _kind, const uint8 _alphabet_width, const uint8 _offset_width, const uint64 _avail_mem) {
+
+		static uint32 trace_idx = 0;
+
+		const std::string fname = std::string("pq_trace_") + pqTraceKindName(_kind) + "_" + std::to_string(trace_idx++) + ".dat";
+
+		m_file = fopen(fname.c_str(), "wb");
+
+		if (m_file == nullptr) {
+
+			std::cerr << "fail to create " << fname << "\n";
+
+			exit(-1);
+		}
+
+		fwrite(&_kind, sizeof(uint8), 1, m_file);
+
+		fwrite(&_alphabet_width, sizeof(uint8), 1, m_file);
+
+		fwrite(&_offset_width, sizeof(uint8), 1, m_file);
+
+		fwrite(&_avail_mem, sizeof(uint64), 1, m_file);
+	}
+
+	/// \brief dtor
+	///
+	~PQTraceWriter() {
+
+		fclose(m_file);
+	}
+
+	/// \brief record an operation other than push
+	///
+	void record(const uint8 _op) {
+
+		fwrite(&_op, sizeof(uint8), 1, m_file);
+	}
+
+	/// \brief record a push operation
+	///
+	void record_push(const uint64 _first, const uint64 _second, const uint64 _third) {
+
+		const uint8 op = PQ_OP_PUSH;
+
+		const uint64 values[3] = {_first, _second, _third};
+
+		fwrite(&op, sizeof(uint8), 1, m_file);
+
+		fwrite(values, sizeof(uint64), 3, m_file);
+	}
+};
+
+/// \brief read a trace written by PQTraceWriter
+///
+class PQTraceReader{
+
+private:
+
+	FILE *m_file; ///< trace file
+
+public:
+
+	uint8 m_kind; ///< kind of the traced priority queue
+
+	uint8 m_alphabet_width; ///< sizeof(alphabet_type)
+
+	uint8 m_offset_width; ///< sizeof(offset_type)
+
+	uint64 m_avail_mem; ///< memory given to the priority queue
+
+public:
+
+	/// \brief ctor, open the trace file and read the header
+	///
+	PQTraceReader(const std::string & _fname) {
+
+		m_file = fopen(_fname.c_str(), "rb");
+
+		if (m_file == nullptr) {
+
+			std::cerr << "fail to open " << _fname << "\n";
+
+			exit(-1);
+		}
+
+		if (fread(&m_kind, sizeof(uint8), 1, m_file) != 1 || fread(&m_alphabet_width, sizeof(uint8), 1, m_file) != 1 ||
+			fread(&m_offset_width, sizeof(uint8), 1, m_file) != 1 || fread(&m_avail_mem, sizeof(uint64), 1, m_file) != 1 || m_kind >= PQ_TRACE_KIND_NUM) {
+
+			std::cerr << _fname << " is not a priority queue trace.\n";
+
+			exit(-1);
+		}
+	}
+
+	/// \brief dtor
+	///
+	~PQTraceReader() {
+
+		fclose(m_file);
+	}
+
+	/// \brief read the next record, _values are filled for a push operation
+	///
+	/// \return false if no more records
+	bool next(uint8 & _op, uint64 * _values) {
+
+		if (fread(&_op, sizeof(uint8), 1, m_file) != 1) return false;
+
+		if (_op == PQ_OP_PUSH && fread(_values, sizeof(uint64), 3, m_file) != 3) return false;
+
+		return true;
+	}
+};
+
+#endif // _TRACE_H
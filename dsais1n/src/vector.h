@@ -7,6 +7,8 @@
 /// The vector is implemented by primitive I/O functions 
 /// The vector provides interfaces for scanning elements rightward and leftward, but it doesn't support random access operations.
 /// The vector supports two read modes: read-only and read-remove.
+/// The vector can also be a view over an existing file, which is never removed, and elements appended to the view are stored in temporary files.
+/// Files of a vector saved to a checkpoint are pinned, they survive read-remove and are removed by Checkpoint once the checkpoint is replaced.
 ///
 /// \author Yi Wu
 /// \date 2017.7
@@ -43,7 +45,7 @@ private:
 
 	private:
 
-		const uint32 m_capacity; ///< the capacity of the buffer, specified by VEC_BUF_RAM in common.h
+		const uint32 m_capacity; ///< the capacity of the buffer, specified by VEC_BUF_RAM in common.h by default
 
 		element_type *m_data; ///< handler to the payload of the buffer
 
@@ -55,7 +57,8 @@ private:
 
 		/// \brief ctor
 		///
-		MyBuf(): m_capacity(VEC_BUF_RAM / sizeof(element_type)) {
+		/// \param _buf_ram size of the buffer (in bytes)
+		MyBuf(const uint64 _buf_ram): m_capacity(_buf_ram / sizeof(element_type)) {
 
 			m_data = new element_type[m_capacity]; // allocate RAM space for buffer
 		}
@@ -199,6 +202,12 @@ private:
 	
 		FILE* m_file; ///< handler
 
+		const uint64 m_offset; ///< offset of the first element in the file
+
+		const bool m_read_only; ///< true if the vector is a view over an existing file
+
+		bool m_pinned; ///< true if the file is kept by a checkpoint
+
 		const uint32 m_capacity; ///< capacity of the vector
 
 		uint32 m_size; ///< number of elements in the vector
@@ -211,7 +220,7 @@ private:
 
 		/// \brief ctor
 		///
-		MyPhiVector(MyBuf*&_buf) : m_capacity(PHI_VEC_EM / sizeof(element_type)), m_buf(_buf) {
+		MyPhiVector(MyBuf*&_buf) : m_offset(0), m_read_only(false), m_pinned(false), m_capacity(PHI_VEC_EM / sizeof(element_type)), m_buf(_buf) {
 
 			m_fname = "tmp_dsais1n_" + std::to_string(global_file_idx) + ".dat";
 	
@@ -220,6 +229,11 @@ private:
 			++global_file_idx; // plus one each time to keep unique
 		}
 
+		/// \brief ctor, over _size elements already in a file starting from _offset
+		///
+		/// \param _read_only true for a view over an existing file, false for a temporary file restored from a checkpoint (pinned)
+		MyPhiVector(MyBuf*&_buf, const std::string & _fname, const uint64 _offset, const uint32 _size, const bool _read_only) : m_fname(_fname), m_offset(_offset), m_read_only(_read_only), m_pinned(!_read_only), m_capacity(PHI_VEC_EM / sizeof(element_type)), m_size(_size), m_buf(_buf) {}
+
 		/// \brief prepare for writing
 		///
 		void start_write() {
@@ -235,7 +249,7 @@ private:
 		///
 		bool full() const{
 
-			return m_size == m_capacity;
+			return m_read_only || m_size == m_capacity;
 		}
 
 		/// \brief put an element into the vector
@@ -258,6 +272,8 @@ private:
 		/// \note call the function after the vector is full
 		void end_write() {
 
+			if (m_read_only) return; // never opened for writing
+
 			if (!m_buf->empty()) { // flush the remaining elements in the buffer
 
 				m_buf->write_block(m_file);
@@ -274,7 +290,7 @@ private:
 	
 			m_read = 0;
 
-			m_buf->read_block(m_file, m_read, std::min(m_size - m_read, m_buf->capacity()));  
+			m_buf->read_block(m_file, m_offset + m_read, std::min(m_size - m_read, m_buf->capacity()));  
 			
 			m_buf->start_read();
 		}
@@ -298,7 +314,7 @@ private:
 
 			//std::cerr << "m_size: " << m_size << " m_read: " << m_read << " m_capacity: " << m_capacity << std::endl;
 
-			m_buf->read_block(m_file, m_size - m_read - std::min(m_size - m_read, m_buf->capacity()), std::min(m_size - m_read, m_buf->capacity()));
+			m_buf->read_block(m_file, m_offset + m_size - m_read - std::min(m_size - m_read, m_buf->capacity()), std::min(m_size - m_read, m_buf->capacity()));
 
 			//std::cerr << "m_size: " << m_size << " m_read: " << m_read << " m_capacity: " << m_capacity << std::endl;
 
@@ -332,7 +348,7 @@ private:
 
 			if (m_buf->is_eof()) { // the elements in the buffer are already processed
 
-				m_buf->read_block(m_file, m_read, std::min(m_size - m_read, m_buf->capacity()));
+				m_buf->read_block(m_file, m_offset + m_read, std::min(m_size - m_read, m_buf->capacity()));
 
 				m_buf->start_read();
 			}		
@@ -346,7 +362,7 @@ private:
 
 			if (m_buf->is_eof()) { // the elements in the buffer are already processed
 
-				m_buf->read_block(m_file, m_size - m_read - std::min(m_size - m_read, m_buf->capacity()), std::min(m_size - m_read, m_buf->capacity()));
+				m_buf->read_block(m_file, m_offset + m_size - m_read - std::min(m_size - m_read, m_buf->capacity()), std::min(m_size - m_read, m_buf->capacity()));
 
 				m_buf->start_read();
 			}
@@ -364,6 +380,8 @@ private:
 		///
 		void remove_file() {
 
+			if (m_read_only || m_pinned) return; // the file is not owned by the vector, or kept by a checkpoint
+
 			std::remove(m_fname.c_str());	
 
 #ifdef STATISTICS_COLLECTION
@@ -382,6 +400,34 @@ private:
 
 			return m_capacity;
 		}
+
+		/// \brief get the file name
+		///
+		const std::string& fname() const {
+
+			return m_fname;
+		}
+
+		/// \brief get the offset of the first element in the file
+		///
+		uint64 offset() const {
+
+			return m_offset;
+		}
+
+		/// \brief check if the vector is a view over an existing file
+		///
+		bool is_read_only() const {
+
+			return m_read_only;
+		}
+
+		/// \brief keep the file for a checkpoint
+		///
+		void pin() {
+
+			m_pinned = true;
+		}
 		
 	};
 
@@ -401,9 +447,10 @@ public:
 
 	/// \brief ctor
 	///
-	MyVector() {
+	/// \param _buf_ram size of the RAM buffer (in bytes)
+	MyVector(const uint64 _buf_ram = VEC_BUF_RAM) {
 
-		m_buf = new MyBuf(); // create the RAM buffer
+		m_buf = new MyBuf(_buf_ram); // create the RAM buffer
 
 		m_phi_vectors.clear();
 
@@ -412,6 +459,70 @@ public:
 		m_flag = false;
 	}	
 
+	/// \brief ctor, a view over an existing file
+	///
+	/// \note elements in the file are never removed, elements appended by push_back are stored in temporary files
+	MyVector(const std::string & _fname) {
+
+		m_buf = new MyBuf(VEC_BUF_RAM); // create the RAM buffer
+
+		m_phi_vectors.clear();
+
+		FILE *file = fopen(_fname.c_str(), "rb");
+
+		if (file == nullptr) {
+
+			std::cerr << "fail to open " << _fname << "\n";
+
+			exit(-1);
+		}
+
+		fseek(file, 0, SEEK_END);
+
+		const uint64 file_size = ftell(file) / sizeof(element_type);
+
+		fclose(file);
+
+		const uint64 phi_capacity = PHI_VEC_EM / sizeof(element_type);
+
+		for (uint64 offset = 0; offset < file_size; offset += phi_capacity) {
+
+			m_phi_vectors.push_back(new MyPhiVector(m_buf, _fname, offset, std::min(file_size - offset, phi_capacity), true));
+		}
+
+		if (m_phi_vectors.empty()) {
+
+			start_write();
+		}
+		else {
+
+			m_size = file_size;
+
+			m_phi_vector_write_idx = m_phi_vectors.size() - 1; // read-only, the next push_back creates a new physical vector
+		}
+
+		m_flag = false;
+	}
+
+private:
+
+	/// \brief tag for the ctor used by restore()
+	///
+	struct RestoreTag{};
+
+	/// \brief ctor, no physical vector is created
+	///
+	MyVector(const RestoreTag &) {
+
+		m_buf = new MyBuf(VEC_BUF_RAM);
+
+		m_read = 0;
+
+		m_flag = false;
+	}
+
+public:
+
 	/// \brief dtor
 	/// 
 	~MyVector() {
@@ -618,6 +729,85 @@ public:
 		}
 	}
 
+	/// \brief finish writing and save the layout (files, offsets and sizes) of the vector to a checkpoint
+	///
+	/// \note the files are pinned for restore(), no element can be appended afterward
+	void save(std::ostream & _out) {
+
+		if (m_flag == false) {
+
+			end_write();
+
+			m_flag = true;
+		}
+
+		_out << m_size << " " << m_phi_vectors.size() << "\n";
+
+		for (uint32 i = 0; i < m_phi_vectors.size(); ++i) {
+
+			_out << m_phi_vectors[i]->fname() << " " << m_phi_vectors[i]->offset() << " " << m_phi_vectors[i]->size() << " " << m_phi_vectors[i]->is_read_only() << "\n";
+
+			m_phi_vectors[i]->pin();
+		}
+	}
+
+	/// \brief restore a vector saved by save(), the files are reused and stay pinned
+	///
+	/// \return nullptr if the layout is broken, or if a file is missing or shorter than recorded
+	static MyVector* restore(std::istream & _in) {
+
+		uint64 size = 0, phi_num = 0, total = 0;
+
+		if (!(_in >> size >> phi_num) || phi_num == 0) return nullptr;
+
+		std::vector<std::string> fnames(phi_num);
+
+		std::vector<uint64> offsets(phi_num), sizes(phi_num);
+
+		std::vector<bool> read_only(phi_num);
+
+		for (uint64 i = 0; i < phi_num; ++i) {
+
+			bool is_read_only;
+
+			if (!(_in >> fnames[i] >> offsets[i] >> sizes[i] >> is_read_only)) return nullptr;
+
+			read_only[i] = is_read_only;
+
+			FILE *file = fopen(fnames[i].c_str(), "rb");
+
+			if (file == nullptr) return nullptr;
+
+			fseek(file, 0, SEEK_END);
+
+			const uint64 file_size = ftell(file) / sizeof(element_type);
+
+			fclose(file);
+
+			if (file_size < offsets[i] + sizes[i]) return nullptr;
+
+			total += sizes[i];
+		}
+
+		if (total != size) return nullptr;
+
+		MyVector *vec = new MyVector(RestoreTag());
+
+		for (uint64 i = 0; i < phi_num; ++i) {
+
+			vec->m_phi_vectors.push_back(new MyPhiVector(vec->m_buf, fnames[i], offsets[i], sizes[i], read_only[i]));
+
+#ifdef STATISTICS_COLLECTION
+
+			if (!read_only[i]) Logger::addPDU(sizes[i] * sizeof(element_type));
+#endif
+		}
+
+		vec->m_size = size, vec->m_phi_vector_write_idx = phi_num - 1, vec->m_flag = true; // writing is finished
+
+		return vec;
+	}
+
 	/// \brief report status
 	///
 	void report() {
@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Copyright (c) 2017, Sun Yat-sen University.
+/// All rights reserved.
+/// \file writer.h
+/// \brief A self-defined writer for producing output files from back to front.
+///
+/// The final suffixes are induced in descending order, while the output files (BWT, SA) are arranged in ascending order.
+/// Given the number of elements in advance, the writer puts each element directly to its final position.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _WRITER_H
+#define _WRITER_H
+
+#include "common.h"
+#include "logger.h"
+
+#include <cstdio>
+#include <string>
+#include <cassert>
+#include <iostream>
+
+#define STATISTICS_COLLECTION
+
+/// \brief write elements from back to front
+///
+/// Elements are received in reverse order and buffered in RAM from the end, a full buffer is written to its final position.
+template<typename element_type>
+class MyReverseWriter{
+
+private:
+
+	const std::string m_fname; ///< output file name
+
+	FILE* m_file; ///< handler
+
+	const uint64 m_size; ///< number of elements in the file
+
+	uint64 m_written; ///< number of elements received
+
+	const uint32 m_capacity; ///< capacity of the buffer, specified by VEC_BUF_RAM in common.h
+
+	element_type *m_data; ///< payload of the buffer, filled from the end
+
+	uint32 m_buf_size; ///< number of elements in the buffer
+
+public:
+
+	/// \brief ctor
+	///
+	MyReverseWriter(const std::string & _fname, const uint64 _size) : m_fname(_fname), m_size(_size), m_capacity(VEC_BUF_RAM / sizeof(element_type)) {
+
+		m_file = fopen(m_fname.c_str(), "wb");
+
+		if (m_file == nullptr) {
+
+			std::cerr << "fail to create " << m_fname << "\n";
+
+			exit(-1);
+		}
+
+		m_written = 0;
+
+		m_data = new element_type[m_capacity];
+
+		m_buf_size = 0;
+	}
+
+	/// \brief dtor
+	///
+	~MyReverseWriter() {
+
+		delete[] m_data; m_data = nullptr;
+	}
+
+	/// \brief receive the element preceding the previous one
+	///
+	void push(const element_type & _elem) {
+
+		if (m_buf_size == m_capacity) {
+
+			flush();
+		}
+
+		m_data[m_capacity - 1 - m_buf_size] = _elem, ++m_buf_size, ++m_written;
+	}
+
+	/// \brief finish writing
+	///
+	/// \note all the elements must be received
+	void finish() {
+
+		assert(m_written == m_size);
+
+		flush();
+
+		if (fclose(m_file) != 0) {
+
+			std::cerr << "fail to write " << m_fname << "\n";
+
+			exit(-1);
+		}
+	}
+
+private:
+
+	/// \brief write the buffer to the file
+	///
+	void flush() {
+
+		if (m_buf_size == 0) return;
+
+		if (fseek(m_file, (m_size - m_written) * sizeof(element_type), SEEK_SET) != 0 ||
+			fwrite(m_data + m_capacity - m_buf_size, sizeof(element_type), m_buf_size, m_file) != m_buf_size) {
+
+			std::cerr << "fail to write " << m_fname << "\n";
+
+			exit(-1);
+		}
+
+#ifdef STATISTICS_COLLECTION
+
+		Logger::addOV(m_buf_size * sizeof(element_type));
+#endif
+
+		m_buf_size = 0;
+	}
+};
+
+#endif // _WRITER_H